@@ -15,9 +15,9 @@ out vec4 FragColor;
 in vec2 TexCoord;
 
 uniform Material material;
-uniform vec4 objColor;
+flat in vec4 Color;
 
 void main()
 { 
-    FragColor = texture(material.texture, TexCoord) * objColor;
+    FragColor = texture(material.texture, TexCoord) * Color;
 }
\ No newline at end of file
@@ -7,17 +7,27 @@
 #include "structure.h"
 #include "ui.h"
 
+#include <atomic>
+#include <future>
+#include <mutex>
 
+
+// animators are moved into a Scene batch when first seen (on START, or on the next fixed step if added later) and played by ClipManager, so their entities also need a Transform
+// :: the Animator2D or AnimatorUV component is removed then, and its parameters are set through Scene::setMachineParameter
 using AnimationStateUV = object::state_machine<AnimationUV>;
 using AnimatorUV = object::state_machine<AnimationStateUV>;
 
 using AnimationState = object::state_machine<Animation2D>;
 using Animator2D = object::state_machine<AnimationState>;
 
+VENUS_NAME(AnimatorUV)
+VENUS_NAME(Animator2D)
+
 struct Application;
 
 struct AnimationManager{};
 struct AnimationUVManager{};
+struct ClipManager{};
 struct AudioManager{};
 struct BillboardManager{};
 struct ButtonManager{};
@@ -28,22 +38,13 @@ struct MeshManager{};
 struct Mesh2DManager{};
 struct PhysicsManager{};
 struct PointLightManager{};
+struct RenderQueueManager{};
 struct SpotLightManager{};
 struct UIManager{};
 
-struct SimpleRenderer
-{
-    int model, view, projection, scale, color, offset, uvScale, flip;
-};
-struct AdvancedRenderer
-{
-    int model, view, projection, scale, color, viewPos, lightDir, lightColor, lightStr, matShininess, matAmb, matDiff, matSpec;
-};
-struct ComplexRenderer
-{
-    bool update = true;
-    int model, view, projection, scale, color, offset, uvScale, flip;
-};
+struct SimpleRenderer{};
+struct AdvancedRenderer{};
+struct ComplexRenderer{};
 struct UIRenderer
 {
     bool update = true;
@@ -95,6 +96,7 @@ struct MeshAddon
     private:
         std::vector<MeshModule> additions;
 };
+VENUS_NAME(MeshAddon)
 
 
 // DirectionalLight (struct): holds data needed to render a directional light
@@ -124,6 +126,12 @@ struct Screen
 
     DirectionalLight dirLight;
     Shader screenShader;
+    RenderQueue queue;
+
+    UniformBuffer cameraBuffer, lightBuffer;
+    CameraBlock cameraBlock;
+    LightBlock lights;
+    LightClusters clusters;
     float gamma;
 
     void initialize(const DirectionalLight& dirLight__, const Shader& screenShader__, uint32_t width, uint32_t height);
@@ -133,18 +141,162 @@ struct Screen
     void store();
     void draw();
     void clear(const Color& color);
+    void updateBlocks(const Camera& cam, const Vector3& position, float aspect);
 
     int getMaximumSamples();
 };
 
+// PartitionCell (struct): marks an entity merged from a WorldPartition cell :: unloading only removes entities still marked with that cell, so ids recycled since the merge are kept
+struct PartitionCell
+{
+    uint64_t key = 0;
+};
+VENUS_NAME(PartitionCell)
+
+// WorldPartition (struct): splits a scene into square cells on the XZ plane that are streamed in from disk around the camera
+struct WorldPartition
+{
+    std::string directory;                  // folder of the cell files, relative to the project root :: streaming is disabled while empty
+    float cellSize = 32;
+    float loadDistance = 64;                // cells whose centers are closer than this are loaded
+    float unloadDistance = 96;              // cells whose centers are farther than this are unloaded :: the gap prevents cells from flickering at the border
+    size_t memoryBudget = 64 * 1024 * 1024; // bytes of serialized cell data allowed to be resident at once
+
+    // called after a cell is merged into the scene :: 'remap' converts the entities saved in the cell to their new values
+    void (*merged)(object::ecs& container, const std::vector<entity>& remap) = nullptr;
+
+    WorldPartition() {}
+    WorldPartition(const std::string& directory__, float cellSize__, float loadDistance__, float unloadDistance__, size_t memoryBudget__ = 64 * 1024 * 1024);
+
+    // copies only the settings :: loaded cells belong to the scene they were merged into
+    WorldPartition(const WorldPartition& partition)
+    {
+        *this = partition;
+    }
+    WorldPartition& operator=(const WorldPartition& partition)
+    {
+        directory = partition.directory;
+        cellSize = partition.cellSize;
+        loadDistance = partition.loadDistance;
+        unloadDistance = partition.unloadDistance;
+        memoryBudget = partition.memoryBudget;
+        merged = partition.merged;
+        return *this;
+    }
+    WorldPartition(WorldPartition&&) = default;
+    WorldPartition& operator=(WorldPartition&&) = default;
+
+    // serializes 'chunk' as the cell at 'cell' inside 'directory' :: 'cell.y' is the cell's Z index
+    static bool save(const std::string& directory, const Vector2I& cell, const object::ecs& chunk);
+
+    Vector2I cellAt(const Vector3& position) const;
+
+    // starts loads and unloads based on 'position' and merges any cells that finished loading into 'container'
+    void update(object::ecs& container, const Vector3& position);
+
+    // unloads every cell and waits for pending loads :: 'container' may be null if its entities were already cleared
+    void clear(object::ecs *container);
+
+    size_t residentBytes() const
+    {
+        return resident;
+    }
+
+    private:
+        enum State
+        {
+            UNLOADED, LOADING, LOADED, MISSING
+        };
+
+        struct Chunk
+        {
+            object::ecs container;
+            size_t bytes = 0;
+            bool found = false;
+        };
+
+        struct Cell
+        {
+            State state = UNLOADED;
+            uint64_t key = 0;
+            size_t bytes = 0;
+            std::vector<entity> entities;
+            std::future<Chunk> chunk;
+        };
+
+        std::unordered_map<uint64_t, Cell> cells;
+        size_t resident = 0;
+
+        static uint64_t key(const Vector2I& cell);
+        std::string path(const Vector2I& cell) const;
+        float distance(const Vector2I& cell, const Vector3& position) const;
+        void unload(object::ecs& container, Cell& cell);
+};
+
+// AnimatorBatch (struct): one animator definition, flattened by object::flatten and shared by every entity registered with it :: 'clips' holds the AnimationClip each state plays
+struct AnimatorBatch
+{
+    object::MachineBatch machine;
+    std::vector<uint32_t> clips;
+    std::vector<std::vector<uint32_t>> offsets; // added to the ids of each nested machine's parameters, per outer state and parameter type
+    std::vector<uint8_t> key; // the serialized definition, clips and offsets, compared when registering
+};
+
 //
 struct Scene
 {
     uint32_t pause = -1;
     object::ecs container;
+    WorldPartition partition;
+
+    // shared animator definitions :: each batch evaluates all of its instances at once and sets the clip of the owning entity's ClipAnimator
+    std::vector<AnimatorBatch> machines;
 
     Scene(const object::ecs& container__);
 
+    // registers animators added since the last call, drops the rows of destroyed or re-registered entities, then evaluates every batch in 'machines' 
+    // and applies the resulting state changes :: run by ClipManager on FIXED_UPDATE, so pausing the scene stops it
+    void updateMachines();
+
+    // registers 'e' with the batch of 'machine' and 'clips', creating it if no batch matches, and points the entity's ClipAnimator at its row
+    // :: from then on the batch owns the entity's state and parameters
+    uint32_t addMachine(entity e, const object::MachineBatch& machine, const std::vector<uint32_t>& clips, const std::vector<std::vector<uint32_t>>& offsets = {});
+    // removes 'e' from its batch :: its ClipAnimator keeps playing the clip it has
+    void removeMachine(entity e);
+
+    template<typename S>
+    void setMachineParameter(entity e, object::parameter identifier, const S& value)
+    {
+        uint32_t batch, index;
+        if(!locateMachine(e, batch, index))
+        {
+            std::cout << "ERROR :: Entity " << e << " is not registered with an animator batch.\n";
+            return;
+        }
+        machines[batch].machine.setParameter<S>(index, identifier, value);
+    }
+
+    // sets a parameter of the machine nested in state 'outer' of the animator 'e' was registered with, by the id that nested machine gave it
+    template<typename S>
+    void setMachineParameter(entity e, object::state outer, object::parameter identifier, const S& value)
+    {
+        uint32_t batch, index;
+        if(!locateMachine(e, batch, index))
+        {
+            std::cout << "ERROR :: Entity " << e << " is not registered with an animator batch.\n";
+            return;
+        }
+
+        const std::vector<std::vector<uint32_t>>& offsets = machines[batch].offsets;
+        if(outer >= offsets.size() || identifier.type >= offsets[outer].size())
+        {
+            std::cout << "ERROR :: State " << outer << " of the animator of entity " << e << " has no nested parameter of that type.\n";
+            return;
+        }
+        identifier.id += offsets[outer][identifier.type];
+        machines[batch].machine.setParameter<S>(index, identifier, value);
+    }
+
     template<typename T>
     void setPausable(uint8_t function)
     {
@@ -161,6 +313,12 @@ struct Scene
     {
         container.toggle(pause);
     }
+
+    private:
+        // finds the batch and row of 'e' through its ClipAnimator :: false if 'e' is not the owner of that row
+        bool locateMachine(entity e, uint32_t& batch, uint32_t& index);
+        // removes row 'index' of 'batch' and repoints the ClipAnimator of the row moved into its place
+        void releaseMachine(uint32_t batch, uint32_t index);
 };
 
 // Time (struct): holds all the timing data that happens between frames :: controls when "fixedUpdate" is run
@@ -176,6 +334,8 @@ struct Time
 
     std::array<double, 10> framerates;
 
+    static constexpr double FIXED_STEP = 0.02; // seconds between "fixedUpdate" runs
+
     Time();
 
     // updates the "fixedUpdate" timer, interpolates deltaTime, and tracks the average framerate
@@ -295,7 +455,7 @@ namespace object
 
     namespace fn
     {
-        extern uint8_t LOAD, START, UPDATE, LATE_UPDATE, FIXED_UPDATE, RENDER, DESTROY;
+        extern uint8_t PREPARE, BUILD, LOAD, START, UPDATE, LATE_UPDATE, FIXED_UPDATE, RENDER, DESTROY;
     }
 
     void defaultInsertion(entity e, std::vector<entity>& entities, std::vector<size_t>& map);
@@ -303,6 +463,48 @@ namespace object
     void setFunctionDefinitions(object::ecs& container, const std::vector<uint8_t *>& references);
 }
 
+// AssetLoader (struct): decodes assets on any thread and queues their GPU uploads for the main thread :: the data PREPARE and BUILD receive
+struct AssetLoader
+{
+    static AssetLoader& data(void *data)
+    {
+        return *((AssetLoader *)data);
+    }
+
+    void preloadMesh(const std::string& path, bool compact = false);
+    void preloadTexture(const std::string& path, Texture::Type type, Texture::Filter filter = Texture::LINEAR);
+
+    // uploads queued assets on the main thread until 'budget' seconds have passed, returns whether the queue is empty
+    bool upload(double budget);
+
+    // returns the fraction of queued assets that have been uploaded
+    float progress() const
+    {
+        uint32_t total = queued;
+        return total ? (float)uploaded / total : 1;
+    }
+
+    void reset()
+    {
+        queued = 0;
+        uploaded = 0;
+    }
+
+    private:
+        struct TextureUpload
+        {
+            std::string path;
+            Texture::Image image;
+            Texture::Type type;
+            Texture::Filter filter;
+        };
+
+        std::mutex lock;
+        std::vector<std::pair<std::string, Mesh>> meshes;
+        std::vector<TextureUpload> textures;
+        std::atomic<uint32_t> queued = 0, uploaded = 0;
+};
+
 struct Application
 {
     static inline InputManager keyboard, mouse;
@@ -363,6 +565,32 @@ struct Application
         setScene(currentScene);
     }
 
+    // loads 'scene' in the background :: runs PREPARE on a worker thread, uploads preloaded assets within 'uploadBudget' each frame, runs BUILD on the
+    // same worker copy, then switches to the scene, where LOAD and START run on the main thread as for any switch
+    // :: PREPARE and BUILD receive the 'AssetLoader' as their data; BUILD may look assets up in the registries, but must not make GL calls
+    void loadSceneAsync(uint32_t scene);
+
+    bool loadingScene() const
+    {
+        return loader.scene != -1;
+    }
+
+    // returns the fraction of the current asynchronous load that has finished :: preparation, uploads and BUILD each count as a third
+    float loadProgress() const;
+
+    // decodes an asset on the calling thread and queues its GPU upload for the main thread
+    void preloadMesh(const std::string& path, bool compact = false)
+    {
+        assets.preloadMesh(path, compact);
+    }
+
+    void preloadTexture(const std::string& path, Texture::Type type, Texture::Filter filter = Texture::LINEAR)
+    {
+        assets.preloadTexture(path, type, filter);
+    }
+
+    double uploadBudget = 0.002; // seconds per frame spent uploading preloaded assets
+
     Time getTime()
     {
         return time;
@@ -405,347 +633,61 @@ struct Application
         uint32_t currentScene = -1, lastScene = -1;
         std::vector<Scene> scenes;
 
+        AssetLoader assets;
+
+        struct SceneLoader
+        {
+            enum Stage {PREPARING, BUILDING};
+
+            uint32_t scene = -1;
+            Stage stage = PREPARING;
+            std::future<object::ecs> preparation;
+            std::vector<std::future<void>> retired; // free the entities of past scenes off the main thread, dropped once finished
+            bool built = false;                     // BUILD already ran on the worker for the scene being switched to
+        } loader;
+
         std::vector<object::Event> events;
 
         Time time;
 
         void updateScene();
+        void updateLoader();
 };
 
 
 template <>
-struct Serialization<ShaderUniforms>
+struct Serialization<ShaderUniforms> : object::Reflected<ShaderUniforms>
 {
-    static size_t length(const ShaderUniforms& value)
-    {        
-        return 
-            object::length(value.booleans) + 
-            object::length(value.integers) +
-            object::length(value.uIntegers) +
-            object::length(value.floats) +
-            object::length(value.doubles) +
-            object::length(value.vBooleans) +
-            object::length(value.vIntegers) +
-            object::length(value.vUIntegers) +
-            object::length(value.vFloats) +
-            object::length(value.vDoubles);
-    }
-
-    static size_t serialize(const ShaderUniforms& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.booleans, stream, index + count);
-        count += object::serialize(value.integers, stream, index + count);
-        count += object::serialize(value.uIntegers, stream, index + count);
-        count += object::serialize(value.floats, stream, index + count);
-        count += object::serialize(value.doubles, stream, index + count);
-        count += object::serialize(value.vBooleans, stream, index + count);
-        count += object::serialize(value.vIntegers, stream, index + count);
-        count += object::serialize(value.vUIntegers, stream, index + count);
-        count += object::serialize(value.vFloats, stream, index + count);
-        count += object::serialize(value.vDoubles, stream, index + count);
-
-        return count;
-    }
-
-    static ShaderUniforms deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        ShaderUniforms result = ShaderUniforms();
-        size_t count = 0;
-
-        result.booleans = object::deserialize<std::vector<bool>>(stream, index + count);
-        count += object::length(result.booleans);
-
-        result.integers = object::deserialize<std::vector<int32_t>>(stream, index + count);
-        count += object::length(result.integers);
-
-        result.uIntegers = object::deserialize<std::vector<uint32_t>>(stream, index + count);
-        count += object::length(result.uIntegers);
-
-        result.floats = object::deserialize<std::vector<float>>(stream, index + count);
-        count += object::length(result.floats);
-
-        result.doubles = object::deserialize<std::vector<double>>(stream, index + count);
-        count += object::length(result.doubles);
-
-        result.vBooleans = object::deserialize<std::vector<Vector2>>(stream, index + count);
-        count += object::length(result.vBooleans);
-        
-        result.vIntegers = object::deserialize<std::vector<Vector2>>(stream, index + count);
-        count += object::length(result.vIntegers);
-
-        result.vUIntegers = object::deserialize<std::vector<Vector2>>(stream, index + count);
-        count += object::length(result.vUIntegers);
-
-        result.vFloats = object::deserialize<std::vector<Vector2>>(stream, index + count);
-        count += object::length(result.vFloats);
-
-        result.vDoubles = object::deserialize<std::vector<Vector2>>(stream, index + count);
-        count += object::length(result.vDoubles);
-
-        return result;
-    }
+    VENUS_FIELDS(ShaderUniforms, booleans, integers, uIntegers, floats, doubles, vBooleans, vIntegers, vUIntegers, vFloats, vDoubles)
 };
 
 
 template <>
-struct Serialization<SimpleShader>
+struct Serialization<SimpleShader> : object::Reflected<SimpleShader>
 {
-    static size_t length(const SimpleShader& value)
-    {        
-        return 
-            object::length(value.values) + 
-            object::length(value.color) +
-            object::length(value.flip);
-    }
-
-    static size_t serialize(const SimpleShader& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.values, stream, index + count);
-        count += object::serialize(value.color, stream, index + count);
-        count += object::serialize(value.flip, stream, index + count);
-
-        return count;
-    }
-
-    static SimpleShader deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        SimpleShader result = SimpleShader();
-        size_t count = 0;
-
-        result.values = object::deserialize<ShaderUniforms>(stream, index + count);
-        count += object::length(result.values);
-
-        result.color = object::deserialize<Color>(stream, index + count);
-        count += object::length(result.color);
-
-        result.flip = object::deserialize<bool>(stream, index + count);
-        count += object::length(result.flip);
-
-        return result;
-    }
+    VENUS_FIELDS(SimpleShader, values, color, flip)
 };
 
 template <>
-struct Serialization<TextShader>
+struct Serialization<TextShader> : object::Reflected<TextShader>
 {
-    static size_t length(const TextShader& value)
-    {        
-        return 
-            object::length(value.values) + 
-            object::length(value.color) +
-            object::length(value.flip);
-    }
-
-    static size_t serialize(const TextShader& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.values, stream, index + count);
-        count += object::serialize(value.color, stream, index + count);
-        count += object::serialize(value.flip, stream, index + count);
-
-        return count;
-    }
-
-    static TextShader deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        TextShader result = TextShader();
-        size_t count = 0;
-
-        result.values = object::deserialize<ShaderUniforms>(stream, index + count);
-        count += object::length(result.values);
-
-        result.color = object::deserialize<Color>(stream, index + count);
-        count += object::length(result.color);
-
-        result.flip = object::deserialize<bool>(stream, index + count);
-        count += object::length(result.flip);
-
-        return result;
-    }
+    VENUS_FIELDS(TextShader, values, color, flip)
 };
 
 template <>
-struct Serialization<ComplexShader>
+struct Serialization<ComplexShader> : object::Reflected<ComplexShader>
 {
-    static size_t length(const ComplexShader& value)
-    {        
-        return 
-            object::length(value.values) + 
-            object::length(value.color) +
-            object::length(value.flip);
-    }
-
-    static size_t serialize(const ComplexShader& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.values, stream, index + count);
-        count += object::serialize(value.color, stream, index + count);
-        count += object::serialize(value.flip, stream, index + count);
-
-        return count;
-    }
-
-    static ComplexShader deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        ComplexShader result = ComplexShader();
-        size_t count = 0;
-
-        result.values = object::deserialize<ShaderUniforms>(stream, index + count);
-        count += object::length(result.values);
-
-        result.color = object::deserialize<Color>(stream, index + count);
-        count += object::length(result.color);
-
-        result.flip = object::deserialize<bool>(stream, index + count);
-        count += object::length(result.flip);
-
-        return result;
-    }
+    VENUS_FIELDS(ComplexShader, values, color, flip)
 };
 
 template <>
-struct Serialization<AdvancedShader>
+struct Serialization<AdvancedShader> : object::Reflected<AdvancedShader>
 {
-    static size_t length(const AdvancedShader& value)
-    {        
-        return 
-            object::length(value.values) + 
-            object::length(value.color) +
-            object::length(value.flip) +
-            object::length(value.ambient) + 
-            object::length(value.diffuse) +
-            object::length(value.specular) +
-            object::length(value.shine);
-    }
-
-    static size_t serialize(const AdvancedShader& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.values, stream, index + count);
-        count += object::serialize(value.color, stream, index + count);
-        count += object::serialize(value.flip, stream, index + count);
-        count += object::serialize(value.ambient, stream, index + count);
-        count += object::serialize(value.diffuse, stream, index + count);
-        count += object::serialize(value.specular, stream, index + count);
-        count += object::serialize(value.shine, stream, index + count);
-
-        return count;
-    }
-
-    static AdvancedShader deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        AdvancedShader result = AdvancedShader();
-        size_t count = 0;
-
-        result.values = object::deserialize<ShaderUniforms>(stream, index + count);
-        count += object::length(result.values);
-
-        result.color = object::deserialize<Color>(stream, index + count);
-        count += object::length(result.color);
-
-        result.flip = object::deserialize<bool>(stream, index + count);
-        count += object::length(result.flip);
-
-        result.ambient = object::deserialize<float>(stream, index + count);
-        count += object::length(result.ambient);
-
-        result.diffuse = object::deserialize<float>(stream, index + count);
-        count += object::length(result.diffuse);
-
-        result.specular = object::deserialize<float>(stream, index + count);
-        count += object::length(result.specular);
-
-        result.shine = object::deserialize<int32_t>(stream, index + count);
-        count += object::length(result.shine);
-        
-
-        return result;
-    }
+    VENUS_FIELDS(AdvancedShader, values, color, flip, ambient, diffuse, specular, shine)
 };
 
 template <>
-struct Serialization<Model>
+struct Serialization<Animation2D> : object::Reflected<Animation2D>
 {
-    static size_t length(const Model& value)
-    {        
-        return 
-            object::length(value.data) + 
-            object::length(value.texture) +
-            object::length(value.offset) +
-            object::length(value.scale);
-    }
-
-    static size_t serialize(const Model& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.data, stream, index + count);
-        count += object::serialize(value.texture, stream, index + count);
-        count += object::serialize(value.offset, stream, index + count);
-        count += object::serialize(value.scale, stream, index + count);
-
-        return count;
-    }
-
-    static Model deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        Model result = Model();
-        size_t count = 0;
-
-        result.data = object::deserialize<Mesh>(stream, index + count);
-        count += object::length(result.data);
-
-        result.texture = object::deserialize<Texture>(stream, index + count);
-        count += object::length(result.texture);
-
-        result.offset = object::deserialize<Vector2>(stream, index + count);
-        count += object::length(result.offset);
-
-        result.scale = object::deserialize<Vector2>(stream, index + count);
-        count += object::length(result.scale);
-
-        return result;
-    }
-};
-
-template <>
-struct Serialization<Animation2D>
-{
-    static size_t length(const Animation2D& data)
-    {        
-        return 
-            object::length(data.frames) +
-            object::length(data.currentFrame);
-    }
-
-    static size_t serialize(const Animation2D& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.frames, stream, index + count);
-        count += object::serialize(value.currentFrame, stream, index + count);
-
-        return count;
-    }
-
-    static Animation2D deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        Animation2D result = Animation2D();
-        size_t count = 0;
-
-        result.frames = object::deserialize<std::vector<Texture>>(stream, index + count);
-        count += object::length(result.frames);
-
-        result.currentFrame = object::deserialize<uint32_t>(stream, index + count);
-        count += object::length(result.currentFrame);
-
-        return result;
-    }
+    VENUS_FIELDS(Animation2D, frames, currentFrame, rate, elapsed)
 };
\ No newline at end of file
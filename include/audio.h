@@ -1,5 +1,7 @@
 #pragma once
 
+#include "serialize.h"
+
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -21,6 +23,7 @@ struct Audio
     private:
         inline static std::unordered_map<std::string, uint32_t> loadedAudios;
 };
+VENUS_NAME(Audio)
 
 struct WAV
 {
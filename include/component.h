@@ -83,6 +83,7 @@ struct PointLight
     PointLight() {}
     PointLight(const Color& color__, float strength__, const Vector3& values) : color(color__), strength(strength__), constant(values.x), linear(values.y), quadratic(values.z) {}
 };
+VENUS_NAME(PointLight)
 
 // SpotLight (struct): holds data needed to render a spotlight
 struct SpotLight
@@ -96,6 +97,7 @@ struct SpotLight
     SpotLight() {}
     SpotLight(const Vector3& direction__, const Color& color__, float strength__, const Vector3& values, float outerCutOff__, float cutoff__) : direction(direction__), color(color__), strength(strength__), constant(values.x), linear(values.y), quadratic(values.z), outerCutOff(outerCutOff__), cutoff(cutoff__) {}
 };
+VENUS_NAME(SpotLight)
 
 
 // RENDERING COMPONENTS
@@ -113,6 +115,7 @@ struct Transform
     Transform(const Vector3& position__, const Quaternion& rotation__) : Transform(position__, vec3::one, rotation__) {}
     Transform(const Vector3& position__, const Vector3& scale__, const Quaternion& rotation__) : position(position__), storedPosition(position__), scale(scale__), rotation(rotation__), lastRotation(rotation__) {}
 };
+VENUS_NAME(Transform)
 
 // Camera (struct): allows for the scene to be rendered from a certain perspective
 struct Camera
@@ -127,6 +130,7 @@ struct Camera
 
     Frustum getFrustum(const Vector3& position, float aspect);
 };
+VENUS_NAME(Camera)
 
 
 // PHYSICS COMPONENTS
@@ -197,6 +201,7 @@ struct Physics2D
         return force/mass;
     }
 };
+VENUS_NAME(Physics2D)
 
 // BoxCollider (struct): calls 'trigger' function whenever another BoxCollider intersects with this one :: otherwise, miss function is called
 struct BoxCollider
@@ -225,6 +230,7 @@ struct BoxCollider
 
     BoxCollider(const Vector3& scale__ = 1, const Vector3& offset__ = 0, uint32_t enter__ = 0, uint32_t exit__ = 0) : scale(scale__), offset(offset__), enterEvent(enter__), exitEvent(exit__) {}
 };
+VENUS_NAME(BoxCollider)
 
 // 
 struct TriCollider
@@ -242,12 +248,14 @@ struct AABB2D
 {
     
 };
+VENUS_NAME(AABB2D)
 
 // 
 struct AABB : AABB2D
 {
 
 };
+VENUS_NAME(AABB)
 
 // Billboard (struct): forces the 'target' to rotate towards the active Camera
 struct Billboard
@@ -255,6 +263,7 @@ struct Billboard
     uint32_t target;
     Vector3 limit = Vector3(1, 1, 1);
 };
+VENUS_NAME(Billboard)
 
 
 // physics (namespace): allows for collision handling with a BoxCollider
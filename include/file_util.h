@@ -81,9 +81,38 @@ namespace file
     // loads file at 'fileName' into std::string vector separated by line
     std::vector<std::string> loadFileToStringVector(const std::string &fileName);
 
+    // loads file at 'fileName' into a byte vector :: with 'decompress', the file must have been written compressed by 'saveBytes'
+    std::vector<uint8_t> loadFileToBytes(const std::string &fileName, bool decompress = false, size_t threads = 1);
+
+    // writes 'data' to the file at 'fileName', replacing its contents :: returns whether the file could be written
+    // a file written with 'compress' must be loaded with 'decompress', since raw data may start like a compressed frame
+    bool saveBytes(const std::string &fileName, const std::vector<uint8_t>& data, bool compress = false, size_t threads = 1);
+
     // bool save(const std::string &fileName, const std::vector<char>& data);
 }
 
+// LZ4-style block compression for serialized data :: blocks are independent, so 'threads' > 1 splits them between worker threads
+namespace compression
+{
+    // size of the uncompressed blocks a frame is split into
+    inline constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+    // compresses 'data' into a frame :: blocks that do not shrink are stored as-is
+    std::vector<uint8_t> compress(const std::vector<uint8_t>& data, size_t threads = 1);
+
+    // decompresses a frame made by 'compress' into 'result' :: returns false if the frame is malformed
+    bool decompress(const std::vector<uint8_t>& data, std::vector<uint8_t>& result, size_t threads = 1);
+
+    // whether 'data' starts with the header of a compressed frame
+    bool compressed(const std::vector<uint8_t>& data);
+
+    // compresses a single block of 'size' bytes into 'destination' :: returns the compressed size, or 0 if it would not fit in 'capacity'
+    size_t compressBlock(const uint8_t *source, size_t size, uint8_t *destination, size_t capacity);
+
+    // decompresses a single block into exactly 'size' bytes of 'destination' :: returns false if the block is malformed
+    bool decompressBlock(const uint8_t *source, size_t length, uint8_t *destination, size_t size);
+}
+
 namespace binary
 {
     int8_t bitArrayToInt8(const std::vector<bool>& arr);
@@ -2,8 +2,10 @@
 
 #include "shader.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 // TextureBuffer (struct): wrapper for graphical texture data
 struct TextureBuffer
@@ -37,6 +39,84 @@ struct FrameBuffer
 };
 
 
+// UniformBuffer (struct): wrapper for a uniform buffer object attached to a fixed binding point :: every shader block bound to that point reads from it
+struct UniformBuffer
+{
+    uint32_t data = 0, binding = 0;
+    size_t size = 0;
+
+    void initialize(uint32_t binding__, size_t size__);
+    void update(const void *value, size_t length, size_t offset = 0);
+    void remove();
+};
+
+// CameraBlock (struct): std140 layout of the shaders' 'Camera' block :: matrices stay row major, as mat4x4 stores them
+struct CameraBlock
+{
+    static constexpr uint32_t BINDING = 0;
+
+    mat4x4 view, projection;
+    Vector3 position;
+    float padding = 0;
+};
+
+// LightBlock (struct): std140 layout of the shaders' 'Lights' block :: besides the directional light, it holds the camera basis fragments use to find their light cluster
+struct LightBlock
+{
+    static constexpr uint32_t BINDING = 1;
+
+    struct Directional
+    {
+        Vector3 direction;
+        float strength = 0;
+        Color color;
+    };
+
+    Directional directional;
+    Vector3 front;
+    float nearDistance = 0;
+    Vector3 right;
+    float tanX = 1;
+    Vector3 up;
+    float tanY = 1;
+    float depthScale = 0;   // depth slices per unit of log(depth / nearDistance)
+    int32_t padding[3] = {};
+};
+
+// LightClusters (struct): bins point and spot lights into a grid of view-space froxels, so each fragment only evaluates the lights reaching its cluster :: the grid size must match CLUSTER_X/Y/Z in object_frag
+struct LightClusters
+{
+    static constexpr uint32_t X = 16, Y = 9, Z = 24, COUNT = X * Y * Z;
+
+    // Light (struct): one light as four RGBA32F texels of 'lightData' :: point lights keep a cut-off below -1, which the shader reads as 'no cone'
+    struct Light
+    {
+        Vector3 position;
+        float strength = 0;
+        Color color;
+        float constant = 0, linear = 0, quadratic = 0, outerCutOff = -2;
+        Vector3 direction;
+        float cutOff = -2;
+    };
+
+    std::vector<Light> points, spots;
+    bool changed = true;   // set by the light managers, cleared once the clusters are rebuilt
+
+    void initialize();
+    void remove();
+    void build(LightBlock& block, const Vector3& position, const Vector3& front, const Vector3& up, float fov, float aspect, float nearDistance, float farDistance);
+    void bind(uint32_t unit) const;
+
+    private:
+        uint32_t buffers[3] = {}, textures[3] = {};
+
+        // froxel bounds in the camera basis, one entry per cluster, stored per axis so the overlap tests vectorize
+        std::vector<float> minimum[3], maximum[3];
+        std::vector<uint32_t> counts, grid;
+        std::vector<uint16_t> indices;
+        std::vector<std::pair<uint32_t, uint16_t>> hits;
+};
+
 struct ShaderUniforms
 {
     std::vector<bool> booleans;
@@ -60,6 +140,7 @@ struct SimpleShader
 
     SimpleShader(const Color& objColor = color::WHITE) : color(objColor), flip(false) {}
 };
+VENUS_NAME(SimpleShader)
 
 //
 struct AdvancedShader : SimpleShader
@@ -69,18 +150,21 @@ struct AdvancedShader : SimpleShader
 
     AdvancedShader(const Color& objColor = color::WHITE, float ambientStrength = 0, float diffuseStrength = 0, float specularStrength = 0, int32_t shininess = 0) : SimpleShader(objColor), ambient(ambientStrength), diffuse(diffuseStrength), specular(specularStrength), shine(shininess) {}
 };
+VENUS_NAME(AdvancedShader)
 
 //
 struct ComplexShader : SimpleShader
 {
     ComplexShader(const Color& objColor = color::WHITE) : SimpleShader(objColor) {}
 };
+VENUS_NAME(ComplexShader)
 
 //
 struct TextShader : SimpleShader
 {
     TextShader(const Color& objColor = color::WHITE) : SimpleShader(objColor) {}
 };
+VENUS_NAME(TextShader)
 
 //
 struct Fade
@@ -89,29 +173,96 @@ struct Fade
 
     Fade(float newRate = 0, float newDistance = 0) : rate(newRate), distance(newDistance) {}
 };
+VENUS_NAME(Fade)
 
-// Model (struct): holds an entity's Texture and Mesh data which allows it to be rendered
+// Model (struct): holds an entity's Texture and a handle to its shared Mesh which allows it to be rendered
 struct Model
 {
     Texture texture;
     Vector2 offset, scale = 1;
-    Mesh data;
+    MeshHandle data;
 
     Model() {}
-    Model(const Texture& texture__, Vector2 offset__, Vector2 scale__, Mesh data__ = Mesh::get("square")) : texture(texture__), offset(offset__), scale(scale__), data(data__)  {}
-    Model(const Texture& texture__, Mesh data__ = Mesh::get("square")) : texture(texture__), data(data__) {}
+    Model(const Texture& texture__, Vector2 offset__, Vector2 scale__, MeshHandle data__ = Mesh::handle("square")) : texture(texture__), offset(offset__), scale(scale__), data(data__)  {}
+    Model(const Texture& texture__, MeshHandle data__ = Mesh::handle("square")) : texture(texture__), data(data__) {}
+
+    Mesh& mesh() const
+    {
+        return Mesh::get(data);
+    }
 
     void refresh()
     {
-        data.refresh();
+        mesh().refresh();
     }
     
-    void render()
+    void render() const
     {
-        data.draw(texture.texture);
+        mesh().draw(texture.texture);
     }
 };
+VENUS_NAME(Model)
+
+// the mesh handle is an index into this process's registry, so a serialized Model stores the mesh's path instead
+template<>
+struct object::Persistence<Model>
+{
+    static void write(const Model& model, std::vector<uint8_t>& stream)
+    {
+        std::string path = Mesh::path(model.data);
+        size_t index = stream.size();
+        stream.resize(index + object::length(path));
+        object::serialize(path, stream, index);
+    }
+
+    static size_t read(Model& model, std::vector<uint8_t>& stream, size_t index)
+    {
+        std::string path = object::deserialize<std::string>(stream, index);
+        model.data = path.empty() ? MeshHandle() : Mesh::handle(path);
+        return object::length(path);
+    }
+};
+
 
+// RenderQueue (struct): collects a frame's draw packets from every renderer, sorts them once by key, and submits them with as few state changes as possible
+struct RenderQueue
+{
+    // DrawPacket (struct): everything the backend binds for one instance :: the instance data itself is kept alongside it
+    struct DrawPacket
+    {
+        uint32_t shader, texture;
+        MeshHandle mesh;
+    };
+
+    // packs, high to low, layer (4 bits) and translucency (1), then shader (7), texture (16), mesh (16) and depth (20) :: translucent packets move depth ahead of the state so they stay back to front
+    static uint64_t key(uint8_t layer, bool translucent, uint8_t shader, uint32_t texture, uint32_t mesh, float depth)
+    {
+        uint64_t quantized = std::clamp(depth, 0.f, 1.f) * 0xFFFFF;
+        uint64_t state = ((uint64_t)(shader & 0x7F) << 32) | ((uint64_t)(texture & 0xFFFF) << 16) | (mesh & 0xFFFF);
+        uint64_t result = ((uint64_t)(layer & 0xF) << 60) | ((uint64_t)translucent << 59);
+        if(translucent)
+            return result | ((0xFFFFF - quantized) << 39) | state;
+        return result | (state << 20) | quantized;
+    }
+
+    // 'depth' is the distance along the camera's front divided by its far distance
+    void add(const Shader& shader, const Model& model, const Instance& instance, float depth, bool translucent = false, uint8_t layer = 0);
+    void submit();
+    void remove();
+
+    size_t size() const
+    {
+        return packets.size();
+    }
+
+    private:
+        uint32_t buffer = 0;
+        std::vector<uint32_t> programs;
+        std::vector<uint64_t> keys, scratchKeys;
+        std::vector<uint32_t> order, scratch;
+        std::vector<DrawPacket> packets;
+        std::vector<Instance> instances, sorted;
+};
 
 // buffer (namespace)
 namespace buffer
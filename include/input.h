@@ -1,5 +1,7 @@
 #pragma once
 
+#include "serialize.h"
+
 #include <bit>
 #include <limits>
 #include <set>
@@ -259,4 +261,5 @@ struct Button
     private:
         uint32_t keys = 0;
         uint32_t buttons = 0;
-};
\ No newline at end of file
+};
+VENUS_NAME(Button)
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "serialize.h"
-#include <unordered_set>
+
+#include <algorithm>
+#include <functional>
 
 namespace object
 {
@@ -24,6 +26,66 @@ namespace object
         LESS, GREATER, LESS_OR_EQUAL, GREATER_OR_EQUAL, NOT_EQUAL, EQUAL, LAST = EQUAL
     };
 
+    /**
+     * @brief The storage type of a parameter, resolved ahead of time so compiled transitions compare it without a type.
+     */
+    enum class ParameterKind : uint8_t
+    {
+        CUSTOM, BOOL, INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64, FLOAT, DOUBLE
+    };
+
+    template<typename S>
+    constexpr ParameterKind parameterKind()
+    {
+        if constexpr(std::is_same<S, bool>::value)
+            return ParameterKind::BOOL;
+        else if constexpr(std::is_same<S, float>::value)
+            return ParameterKind::FLOAT;
+        else if constexpr(std::is_same<S, double>::value)
+            return ParameterKind::DOUBLE;
+        else if constexpr(std::is_integral<S>::value && sizeof(S) == 1)
+            return std::is_signed<S>::value ? ParameterKind::INT8 : ParameterKind::UINT8;
+        else if constexpr(std::is_integral<S>::value && sizeof(S) == 2)
+            return std::is_signed<S>::value ? ParameterKind::INT16 : ParameterKind::UINT16;
+        else if constexpr(std::is_integral<S>::value && sizeof(S) == 4)
+            return std::is_signed<S>::value ? ParameterKind::INT32 : ParameterKind::UINT32;
+        else if constexpr(std::is_integral<S>::value && sizeof(S) == 8)
+            return std::is_signed<S>::value ? ParameterKind::INT64 : ParameterKind::UINT64;
+        else
+            return ParameterKind::CUSTOM;
+    }
+
+    template<typename S>
+    bool compareParameters(const S& first, const S& second, uint8_t condition)
+    {
+        switch(condition)
+        {
+            case LESS:
+                return first < second;
+            case GREATER:
+                return first > second;
+            case LESS_OR_EQUAL:
+                return first <= second;
+            case GREATER_OR_EQUAL:
+                return first >= second;
+            case NOT_EQUAL:
+                return first != second;
+            case EQUAL:
+                return first == second;
+        }
+        return false;
+    }
+
+    /**
+     * @brief What is known about a parameter type once its bytes are stored :: registered with the type's id.
+     */
+    struct ParameterInfo
+    {
+        bool (*compare)(const uint8_t *, const uint8_t *, uint8_t);
+        uint32_t size;
+        ParameterKind kind;
+    };
+
     struct Transition
     {
         state target;
@@ -45,13 +107,31 @@ namespace object
         template<typename T>
         static uint32_t newId()
         {
-            uint32_t index = idCount;
-            idCount++;
-            return index;
+            static_assert(std::is_trivially_copyable<T>::value, "parameters are stored as raw bytes");
+
+            // parameter ids are assigned during static initialization, so the registry is created on first use
+            std::vector<ParameterInfo>& registry = infos();
+            registry.push_back({[](const uint8_t *one, const uint8_t *two, uint8_t condition)
+            {
+                T first, second;
+                std::memcpy((void *)&first, one, sizeof(T));
+                std::memcpy((void *)&second, two, sizeof(T));
+                return compareParameters(first, second, condition);
+            }, (uint32_t)sizeof(T), parameterKind<T>()});
+            return registry.size() - 1;
+        }
+
+        static const ParameterInfo& info(size_t type)
+        {
+            return infos()[type];
         }
 
         private:
-            inline static uint32_t idCount = 0;
+            static std::vector<ParameterInfo>& infos()
+            {
+                static std::vector<ParameterInfo> registry;
+                return registry;
+            }
     };
 
     struct ParameterLoc
@@ -84,6 +164,83 @@ namespace object
         static const uint32_t id; /** @brief The unique ID assigned to a type.*/
     };
 
+    struct CompiledTransition
+    {
+        state target;
+        uint32_t one, two; /** @brief Byte offsets of the compared parameters in `CompiledMachine::values`.*/
+        uint32_t type;
+        uint8_t opcode; /** @brief `(ParameterKind << 3) | condition`.*/
+        uint8_t valid;
+    };
+
+    /**
+     * @brief A `state_machine`'s transitions and parameters frozen into flat arrays by `state_machine::compile`.
+     * 
+     * @details The transitions of state `s` are `transitions[ranges[s]]` to `transitions[ranges[s + 1]]`. Parameters of 
+     *          every type are packed into `values`; a parameter `{type, id}` is slot `slots[type] + id`, and the 
+     *          transitions that compare it are listed in `dependencies` from `dependencyRanges[slot]` to 
+     *          `dependencyRanges[slot + 1]`.
+     */
+    struct CompiledMachine
+    {
+        std::vector<uint32_t> ranges;
+        std::vector<CompiledTransition> transitions;
+
+        std::vector<uint8_t> values;
+        std::vector<uint32_t> bases, slots;
+        std::vector<uint32_t> dependencyRanges, dependencies;
+
+        VENUS_FIELDS(CompiledMachine, ranges, transitions, values, bases, slots, dependencyRanges, dependencies)
+
+        bool empty() const
+        {
+            return ranges.empty();
+        }
+
+        bool evaluate(const CompiledTransition& t) const
+        {
+            const uint8_t *one = values.data() + t.one, *two = values.data() + t.two;
+            uint8_t condition = t.opcode & 7;
+            switch((ParameterKind)(t.opcode >> 3))
+            {
+                case ParameterKind::BOOL:
+                    return compareParameters(load<bool>(one), load<bool>(two), condition);
+                case ParameterKind::INT8:
+                    return compareParameters(load<int8_t>(one), load<int8_t>(two), condition);
+                case ParameterKind::UINT8:
+                    return compareParameters(load<uint8_t>(one), load<uint8_t>(two), condition);
+                case ParameterKind::INT16:
+                    return compareParameters(load<int16_t>(one), load<int16_t>(two), condition);
+                case ParameterKind::UINT16:
+                    return compareParameters(load<uint16_t>(one), load<uint16_t>(two), condition);
+                case ParameterKind::INT32:
+                    return compareParameters(load<int32_t>(one), load<int32_t>(two), condition);
+                case ParameterKind::UINT32:
+                    return compareParameters(load<uint32_t>(one), load<uint32_t>(two), condition);
+                case ParameterKind::INT64:
+                    return compareParameters(load<int64_t>(one), load<int64_t>(two), condition);
+                case ParameterKind::UINT64:
+                    return compareParameters(load<uint64_t>(one), load<uint64_t>(two), condition);
+                case ParameterKind::FLOAT:
+                    return compareParameters(load<float>(one), load<float>(two), condition);
+                case ParameterKind::DOUBLE:
+                    return compareParameters(load<double>(one), load<double>(two), condition);
+                case ParameterKind::CUSTOM:
+                    return Transition::info(t.type).compare(one, two, condition);
+            }
+            return false;
+        }
+
+        private:
+            template<typename S>
+            static S load(const uint8_t *data)
+            {
+                S value;
+                std::memcpy(&value, data, sizeof(S));
+                return value;
+            }
+    };
+
     template<typename T>
     struct state_machine
     {
@@ -93,15 +250,90 @@ namespace object
         std::vector<std::vector<Transition>> transitions;
         std::vector<ParameterArray> parameters;
 
+        CompiledMachine table; /** @brief Filled by `compile`; emptied again when states, parameters or transitions are added.*/
+
         state_machine()
         {
             states = std::vector<T>();
             transitions = std::vector<std::vector<Transition>>();
         }
 
+        /**
+         * @brief Freezes the current transitions and parameters into flat tables, so that `setParameter` evaluates 
+         *        only the transitions depending on a parameter, with pre-resolved comparisons and no allocation.
+         */
+        void compile()
+        {
+            decompile();
+
+            uint32_t slotCount = 0;
+            for(size_t type = 0; type < parameters.size(); type++)
+            {
+                table.bases.push_back(table.values.size());
+                table.slots.push_back(slotCount);
+                table.values.insert(table.values.end(), parameters[type].data.begin(), parameters[type].data.end());
+                slotCount += parameters[type].states.size();
+            }
+
+            table.ranges.push_back(0);
+            for(const auto& outgoing : transitions)
+            {
+                for(const Transition& t : outgoing)
+                {
+                    const ParameterInfo& info = Transition::info(t.one.type);
+                    CompiledTransition compiled = {t.target, table.bases[t.one.type] + t.one.id * info.size, table.bases[t.two.type] + t.two.id * info.size, 
+                        (uint32_t)t.one.type, (uint8_t)(((uint8_t)info.kind << 3) | t.trans), 0};
+                    compiled.valid = table.evaluate(compiled);
+                    table.transitions.push_back(compiled);
+                }
+                table.ranges.push_back(table.transitions.size());
+            }
+
+            table.dependencyRanges.push_back(0);
+            for(const ParameterArray& array : parameters)
+            {
+                for(const auto& locations : array.states)
+                {
+                    for(const ParameterLoc& loc : locations)
+                    {
+                        table.dependencies.push_back(table.ranges[loc.location] + loc.index);
+                    }
+                    table.dependencyRanges.push_back(table.dependencies.size());
+                }
+            }
+        }
+
+        bool compiled() const
+        {
+            return !table.empty();
+        }
+
+        // returns the parameter values and valid flags to 'parameters' and 'transitions', and drops the compiled tables
+        void decompile()
+        {
+            if(!compiled())
+                return;
+
+            for(size_t type = 0; type < parameters.size(); type++)
+            {
+                std::vector<uint8_t>& data = parameters[type].data;
+                if(data.size())
+                    std::memcpy(data.data(), &table.values[table.bases[type]], data.size());
+            }
+
+            for(size_t s = 0; s < transitions.size(); s++)
+            {
+                for(size_t i = 0; i < transitions[s].size(); i++)
+                {
+                    transitions[s][i].valid = table.transitions[table.ranges[s] + i].valid;
+                }
+            }
+            table = CompiledMachine();
+        }
 
         state createState(const T& newState)
         {
+            decompile();
             size_t size = states.size();
             states.push_back(newState);
             transitions.push_back(std::vector<Transition>());
@@ -128,6 +360,7 @@ namespace object
         template<typename S>
         parameter createParameter(const S& param = S())
         {
+            decompile();
             uint32_t id = ParameterType<S>::id;
             size_t size = parameters.size();
             while(id >= size)
@@ -147,6 +380,9 @@ namespace object
         S getParameter(parameter identifier)
         {
             uint32_t id = ParameterType<S>::id;
+            if(compiled())
+                return object::deserialize<S>(table.values, table.bases[id] + identifier.id * sizeof(S));
+
             std::vector<uint8_t>& stream = parameters[id].data;
             return object::deserialize<S>(stream, identifier.id * sizeof(S));
         }
@@ -155,17 +391,31 @@ namespace object
         void setParameter(parameter identifier, const S& param)
         {
             uint32_t id = ParameterType<S>::id;
-            std::vector<uint8_t>& stream = parameters[id].data;
-            object::serialize(param, stream, identifier.id * sizeof(S));
-
-            std::vector<ParameterLoc>& locs = parameters[id].states[identifier.id];
             bool updated = false;
-            for(const ParameterLoc& loc : locs)
+            if(compiled())
             {
-                Transition& t = transitions[loc.location][loc.index];
-                updated = t.valid;
-                t.valid = parametersEqual<S>(t.trans, t.one, t.two);
-                updated = (updated != t.valid);
+                // every transition depending on a parameter of type 'S' compares two values of type 'S'
+                uint32_t slot = table.slots[id] + identifier.id;
+                object::serialize(param, table.values, table.bases[id] + identifier.id * sizeof(S));
+                for(uint32_t i = table.dependencyRanges[slot]; i < table.dependencyRanges[slot + 1]; i++)
+                {
+                    CompiledTransition& t = table.transitions[table.dependencies[i]];
+                    uint8_t valid = compareParameters(object::deserialize<S>(table.values, t.one), object::deserialize<S>(table.values, t.two), t.opcode & 7);
+                    updated |= (valid != t.valid);
+                    t.valid = valid;
+                }
+            }
+            else
+            {
+                object::serialize(param, parameters[id].data, identifier.id * sizeof(S));
+
+                for(const ParameterLoc& loc : parameters[id].states[identifier.id])
+                {
+                    Transition& t = transitions[loc.location][loc.index];
+                    bool valid = parametersEqual<S>(t.trans, t.one, t.two);
+                    updated |= (valid != t.valid);
+                    t.valid = valid;
+                }
             }
 
             if(updated)
@@ -175,18 +425,19 @@ namespace object
         template<typename S>
         void createTransition(state initial, state target, parameter one, parameter two, transition trans)
         {
-            Transition t;
             if(initial < states.size())
             {
+                decompile();
                 ParameterLoc loc = ParameterLoc(initial, transitions[initial].size());
                 parameters[one.type].states[one.id].push_back(loc);
                 parameters[two.type].states[two.id].push_back(loc);
-                transitions[initial].push_back(t = Transition(target, trans, one, two));
-            
-                if(parametersEqual<S>(t.trans, t.one, t.two))
-                {
-                    currentState = t.target;
-                }
+
+                Transition t = Transition(target, trans, one, two);
+                t.valid = parametersEqual<S>(t.trans, t.one, t.two);
+                transitions[initial].push_back(t);
+
+                if(t.valid && initial == currentState)
+                    update();
             }
         }
 
@@ -199,135 +450,493 @@ namespace object
         }
 
         private:
+            // follows the first valid transition out of each state until none leads to a state not yet visited this call
             void update()
             {
-                std::unordered_set<state> lastStates = std::unordered_set<state>();
-                lastStates.insert(currentState);
-                bool switched = false;
-                do
+                // machines of up to 256 states track visited states without allocating
+                uint64_t local[4] = {};
+                std::vector<uint64_t> large;
+                uint64_t *visited = local;
+                if(states.size() > 256)
+                {
+                    large.resize((states.size() + 63) / 64);
+                    visited = large.data();
+                }
+
+                // targets past the last state count as visited, so they are never followed
+                auto open = [&](state target)
+                {
+                    return target < states.size() && !(visited[target / 64] & (1ull << (target % 64)));
+                };
+
+                while(currentState < states.size())
                 {
-                    for(const auto& trans : transitions[currentState])
+                    visited[currentState / 64] |= 1ull << (currentState % 64);
+                    state next = currentState;
+                    if(compiled())
+                    {
+                        for(uint32_t i = table.ranges[currentState]; i < table.ranges[currentState + 1]; i++)
+                        {
+                            const CompiledTransition& t = table.transitions[i];
+                            if(t.valid && open(t.target))
+                            {
+                                next = t.target;
+                                break;
+                            }
+                        }
+                    }
+                    else
                     {
-                        if((switched = trans.valid) && lastStates.find(trans.target) == lastStates.end())
+                        for(const Transition& t : transitions[currentState])
                         {
-                            currentState = trans.target;
-                            lastStates.insert(currentState);
+                            if(t.valid && open(t.target))
+                            {
+                                next = t.target;
+                                break;
+                            }
                         }
                     }
+
+                    if(next == currentState)
+                        break;
+                    currentState = next;
                 }
-                while(switched);
             }
 
             template<typename S>
             bool parametersEqual(transition t, parameter one, parameter two)
             {
-                S first = getParameter<S>(one);
-                S second = getParameter<S>(two);
-                switch(t)
-                {
-                    case LESS:
-                        return first < second;
-                    break;
-                    case GREATER:
-                        return first > second;
-                    break;
-                    case LESS_OR_EQUAL:
-                        return first <= second;
-                    break;
-                    case GREATER_OR_EQUAL:
-                        return first >= second;
-                    break;
-                    case NOT_EQUAL:
-                        return first != second;
-                    break;
-                    case EQUAL:
-                        return first == second;
-                    break;
-                }
-                return false;
+                return compareParameters(getParameter<S>(one), getParameter<S>(two), t);
             }
     };
 
     template <typename T>
     inline const uint32_t ParameterType<T>::id = Transition::newId<T>();
-}
 
-template<>
-struct Serialization<object::ParameterArray>
-{
-    static size_t length(const object::ParameterArray& data)
+    /**
+     * @brief Turns a machine whose states are machines into one machine over the inner states, so that it can be batched.
+     * 
+     * @details Inner state `i` of outer state `s` becomes one state of the result; an outer state with no inner states 
+     *          becomes a single state holding `T()`. Each resulting state tests the outer transitions of `s` before the 
+     *          inner transitions of `i`. An outer transition enters its target's inner machine at the state that machine 
+     *          is in now, so re-entering an outer state starts its inner machine over instead of resuming it. The outer 
+     *          parameters keep their ids, and parameter `{type, id}` of the inner machine of `s` becomes 
+     *          `{type, id + offsets[s][type]}`.
+     */
+    template<typename T>
+    state_machine<T> flatten(state_machine<state_machine<T>> machine, std::vector<std::vector<uint32_t>>& offsets)
     {
-        return
-            object::length(data.data) +
-            object::length(data.states);
-    }
+        state_machine<T> result;
+        std::vector<state> first;
+        for(state_machine<T>& inner : machine.states)
+        {
+            // compiling moves the current parameter values into 'table', whether or not the machine was compiled before
+            inner.compile();
+            first.push_back(result.states.size());
+            if(inner.states.empty())
+                result.states.push_back(T());
+            result.states.insert(result.states.end(), inner.states.begin(), inner.states.end());
+        }
+        machine.compile();
 
-    static size_t serialize(const object::ParameterArray& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
+        state count = result.states.size();
+        result.transitions.resize(count);
 
-        count += object::serialize(value.data, stream, index + count);
-        count += object::serialize(value.states, stream, index + count);
+        // the first state of outer state 'target', or a state past the last one if there is no such outer state
+        auto enter = [&](state target) -> state
+        {
+            if(target >= machine.states.size())
+                return count;
+            const state_machine<T>& inner = machine.states[target];
+            return first[target] + (inner.currentState < inner.states.size() ? inner.currentState : 0);
+        };
 
-        return count;
-    }
+        auto append = [&](const auto& source, std::vector<uint32_t>& offset)
+        {
+            for(size_t type = 0; type < source.parameters.size(); type++)
+            {
+                if(result.parameters.size() <= type)
+                    result.parameters.resize(type + 1);
+
+                ParameterArray& array = result.parameters[type];
+                size_t bytes = source.parameters[type].data.size();
+                const uint8_t *values = source.table.values.data() + source.table.bases[type];
+                offset.push_back(array.states.size());
+                array.data.insert(array.data.end(), values, values + bytes);
+                array.states.resize(array.states.size() + source.parameters[type].states.size());
+            }
+        };
 
-    static object::ParameterArray deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        object::ParameterArray result = object::ParameterArray();
-        size_t count = 0;
+        auto link = [&](state source, Transition t, const std::vector<uint32_t>& offset)
+        {
+            t.one.id += offset[t.one.type];
+            t.two.id += offset[t.two.type];
+            ParameterLoc loc = ParameterLoc(source, result.transitions[source].size());
+            result.parameters[t.one.type].states[t.one.id].push_back(loc);
+            result.parameters[t.two.type].states[t.two.id].push_back(loc);
+            result.transitions[source].push_back(t);
+        };
+
+        std::vector<uint32_t> outer;
+        append(machine, outer);
+        offsets.assign(machine.states.size(), std::vector<uint32_t>());
+        for(state s = 0; s < machine.states.size(); s++)
+        {
+            append(machine.states[s], offsets[s]);
+        }
 
-        result.data = object::deserialize<std::vector<uint8_t>>(stream, index + count);
-        count += object::length(result.data);
+        for(state s = 0; s < machine.states.size(); s++)
+        {
+            const state_machine<T>& inner = machine.states[s];
+            state size = std::max<state>(inner.states.size(), 1);
+            for(state i = 0; i < size; i++)
+            {
+                for(Transition t : machine.transitions[s])
+                {
+                    t.target = enter(t.target);
+                    link(first[s] + i, t, outer);
+                }
+                if(i >= inner.transitions.size())
+                    continue;
 
-        result.states = object::deserialize<std::vector<std::vector<object::ParameterLoc>>>(stream, index + count);
-        count += object::length(result.states);
+                for(Transition t : inner.transitions[i])
+                {
+                    t.target = t.target < inner.states.size() ? first[s] + t.target : count;
+                    link(first[s] + i, t, offsets[s]);
+                }
+            }
+        }
 
+        result.currentState = enter(machine.currentState);
         return result;
     }
-};
 
-template<typename T>
-struct Serialization<object::state_machine<T>>
-{
-    static size_t length(const object::state_machine<T>& data)
+    struct MachineChange
     {
-        return
-            object::length(data.states) +
-            object::length(data.currentState) +
-            object::length(data.transitions) +
-            object::length(data.parameters);
-    }
+        uint32_t owner;
+        state target;
+    };
 
-    static size_t serialize(const object::state_machine<T>& value, std::vector<uint8_t>& stream, size_t index)
+    /**
+     * @brief Many instances of one compiled `state_machine` definition, stored as columns and evaluated together.
+     * 
+     * @details Each instance has an owner (usually an entity), a current state, and one value per parameter slot; 
+     *          slot `s` of every instance is packed into `columns[s]`. `evaluate` tests each transition against all 
+     *          instances in a single loop and follows transitions the way `state_machine` does: the first valid 
+     *          transition out of a state is taken, and no state is entered twice in one evaluation.
+     */
+    struct MachineBatch
     {
-        size_t count = 0;
+        CompiledMachine definition;
+        std::vector<uint32_t> sizes;    /** @brief The byte size of each parameter slot.*/
+        std::vector<uint32_t> operands; /** @brief The slots compared by transition `i`, at `2 * i` and `2 * i + 1`.*/
+        std::vector<uint32_t> defaults; /** @brief Where each slot's initial value is in `definition.values`.*/
+        state initial = 0;
+        uint32_t stateCount = 0;
 
-        count += object::serialize(value.states, stream, index + count);
-        count += object::serialize(value.currentState, stream, index + count);
-        count += object::serialize(value.transitions, stream, index + count);
-        count += object::serialize(value.parameters, stream, index + count);
+        std::vector<uint32_t> owners;
+        std::vector<state> current;
+        std::vector<std::vector<uint8_t>> columns;
 
-        return count;
-    }
+        VENUS_FIELDS(MachineBatch, definition, sizes, operands, defaults, initial, stateCount, owners, current, columns)
 
-    static object::state_machine<T> deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        object::state_machine<T> result = object::state_machine<T>();
-        size_t count = 0;
+        MachineBatch() {}
+
+        template<typename T>
+        MachineBatch(state_machine<T> machine)
+        {
+            machine.compile();
+            definition = machine.table;
+            initial = machine.currentState;
+            stateCount = machine.states.size();
+
+            uint32_t slotCount = definition.dependencyRanges.size() - 1;
+            for(uint32_t type = 0; type < definition.slots.size(); type++)
+            {
+                uint32_t end = type + 1 < definition.slots.size() ? definition.slots[type + 1] : slotCount;
+                for(uint32_t slot = definition.slots[type]; slot < end; slot++)
+                {
+                    sizes.push_back(Transition::info(type).size);
+                    defaults.push_back(definition.bases[type] + (slot - definition.slots[type]) * sizes.back());
+                }
+            }
+            columns.resize(slotCount);
+
+            for(const CompiledTransition& t : definition.transitions)
+            {
+                for(uint32_t offset : {t.one, t.two})
+                {
+                    operands.push_back(definition.slots[t.type] + (offset - definition.bases[t.type]) / sizes[definition.slots[t.type]]);
+                }
+            }
+        }
+
+        /**
+         * @brief Adds an instance in the definition's initial state with its parameters' initial values.
+         * 
+         * @return The index of the new instance.
+         */
+        uint32_t add(uint32_t owner)
+        {
+            owners.push_back(owner);
+            current.push_back(initial);
+            for(size_t slot = 0; slot < columns.size(); slot++)
+            {
+                const uint8_t *value = definition.values.data() + defaults[slot];
+                columns[slot].insert(columns[slot].end(), value, value + sizes[slot]);
+            }
+            return owners.size() - 1;
+        }
+
+        /**
+         * @brief Removes the instance at `index`; the last instance takes its place.
+         */
+        void remove(uint32_t index)
+        {
+            uint32_t last = owners.size() - 1;
+            owners[index] = owners[last];
+            current[index] = current[last];
+            owners.pop_back();
+            current.pop_back();
+            for(size_t slot = 0; slot < columns.size(); slot++)
+            {
+                if(index != last)
+                    std::memcpy(&columns[slot][index * sizes[slot]], &columns[slot][last * sizes[slot]], sizes[slot]);
+                columns[slot].resize(last * sizes[slot]);
+            }
+        }
+
+        /**
+         * @brief Returns the index of the instance belonging to `owner`, or -1.
+         * 
+         * @details Scans every instance; callers that look instances up every tick should keep the index `add` returned, 
+         *          updating it when `remove` moves the last instance.
+         */
+        uint32_t find(uint32_t owner) const
+        {
+            for(uint32_t i = 0; i < owners.size(); i++)
+            {
+                if(owners[i] == owner)
+                    return i;
+            }
+            return -1;
+        }
+
+        size_t size() const
+        {
+            return owners.size();
+        }
+
+        template<typename S>
+        void setParameter(uint32_t index, parameter identifier, const S& value)
+        {
+            std::memcpy(column<S>(identifier) + index, &value, sizeof(S));
+        }
+
+        template<typename S>
+        S getParameter(uint32_t index, parameter identifier)
+        {
+            return column<S>(identifier)[index];
+        }
+
+        /**
+         * @brief The values of a parameter for every instance, in instance order, for writing many at once.
+         */
+        template<typename S>
+        S *column(parameter identifier)
+        {
+            return reinterpret_cast<S *>(columns[definition.slots[identifier.type] + identifier.id].data());
+        }
+
+        /**
+         * @brief Moves every instance along its valid transitions.
+         * 
+         * @return The instances whose state changed, with their new states; valid until the next call.
+         */
+        const std::vector<MachineChange>& evaluate()
+        {
+            size_t count = owners.size(), words = (stateCount + 63) / 64;
+            changes.clear();
+            if(!stateCount)
+                return changes;
+
+            previous = current;
+            next.resize(count);
+
+            // bit 's' of instance 'i' is in word 's / 64' of column 'i', so each transition tests one contiguous row
+            visited.assign(words * count, 0);
+            for(size_t i = 0; i < count; i++)
+            {
+                visited[current[i] / 64 * count + i] |= 1ull << (current[i] % 64);
+            }
+
+            for(uint32_t pass = 0; pass < stateCount; pass++)
+            {
+                next = current;
+
+                // transitions are tested last to first, so the first valid one out of a state is the one that remains
+                for(state s = stateCount; s-- > 0;)
+                {
+                    for(uint32_t t = definition.ranges[s + 1]; t-- > definition.ranges[s];)
+                    {
+                        if(definition.transitions[t].target < stateCount)
+                            test(s, t);
+                    }
+                }
+
+                bool moved = false;
+                for(size_t i = 0; i < count; i++)
+                {
+                    if(next[i] != current[i])
+                    {
+                        current[i] = next[i];
+                        visited[current[i] / 64 * count + i] |= 1ull << (current[i] % 64);
+                        moved = true;
+                    }
+                }
+                if(!moved)
+                    break;
+            }
+
+            for(size_t i = 0; i < count; i++)
+            {
+                if(current[i] != previous[i])
+                    changes.push_back({owners[i], current[i]});
+            }
+            return changes;
+        }
+
+        private:
+            std::vector<state> previous, next;
+            std::vector<uint64_t> visited;
+            std::vector<MachineChange> changes;
+
+            void test(state source, uint32_t index)
+            {
+                const CompiledTransition& t = definition.transitions[index];
+                switch((ParameterKind)(t.opcode >> 3))
+                {
+                    case ParameterKind::BOOL:
+                        return test<bool>(source, index);
+                    case ParameterKind::INT8:
+                        return test<int8_t>(source, index);
+                    case ParameterKind::UINT8:
+                        return test<uint8_t>(source, index);
+                    case ParameterKind::INT16:
+                        return test<int16_t>(source, index);
+                    case ParameterKind::UINT16:
+                        return test<uint16_t>(source, index);
+                    case ParameterKind::INT32:
+                        return test<int32_t>(source, index);
+                    case ParameterKind::UINT32:
+                        return test<uint32_t>(source, index);
+                    case ParameterKind::INT64:
+                        return test<int64_t>(source, index);
+                    case ParameterKind::UINT64:
+                        return test<uint64_t>(source, index);
+                    case ParameterKind::FLOAT:
+                        return test<float>(source, index);
+                    case ParameterKind::DOUBLE:
+                        return test<double>(source, index);
+                    case ParameterKind::CUSTOM:
+                        return test<void>(source, index);
+                }
+            }
 
-        result.states = object::deserialize<std::vector<T>>(stream, index + count);
-        count += object::length(result.states);
+            // marks, in 'next', every instance in 'source' that transition 'index' moves to an unvisited state
+            template<typename S>
+            void test(state source, uint32_t index)
+            {
+                const CompiledTransition& t = definition.transitions[index];
+                const std::vector<uint8_t>& one = columns[operands[2 * index]];
+                const std::vector<uint8_t>& two = columns[operands[2 * index + 1]];
 
-        result.currentState = object::deserialize<object::state>(stream, index + count);
-        count += object::length(result.currentState);
+                size_t count = owners.size();
+                const uint64_t *seen = visited.data() + t.target / 64 * count;
+                uint64_t bit = 1ull << (t.target % 64);
+                uint8_t condition = t.opcode & 7;
+                state target = t.target;
 
-        result.transitions = object::deserialize<std::vector<std::vector<object::Transition>>>(stream, index + count);
-        count += object::length(result.transitions);
+                if constexpr(std::is_void<S>::value)
+                {
+                    auto compare = Transition::info(t.type).compare;
+                    uint32_t size = sizes[operands[2 * index]];
+                    for(size_t i = 0; i < count; i++)
+                    {
+                        if(current[i] == source && !(seen[i] & bit) && compare(&one[i * size], &two[i * size], condition))
+                            next[i] = target;
+                    }
+                }
+                else
+                {
+                    const S *first = reinterpret_cast<const S *>(one.data());
+                    const S *second = reinterpret_cast<const S *>(two.data());
+                    const state *states = current.data();
+                    state *moves = next.data();
 
-        result.parameters = object::deserialize<std::vector<object::ParameterArray>>(stream, index + count);
-        count += object::length(result.parameters);
+                    // the condition is resolved outside the loop so that the loop body has no branches
+                    auto run = [&](auto compare)
+                    {
+                        for(size_t i = 0; i < count; i++)
+                        {
+                            bool taken = (states[i] == source) & !(seen[i] & bit) & compare(first[i], second[i]);
+                            moves[i] = taken ? target : moves[i];
+                        }
+                    };
+                    switch(condition)
+                    {
+                        case LESS:
+                            return run(std::less<S>());
+                        case GREATER:
+                            return run(std::greater<S>());
+                        case LESS_OR_EQUAL:
+                            return run(std::less_equal<S>());
+                        case GREATER_OR_EQUAL:
+                            return run(std::greater_equal<S>());
+                        case NOT_EQUAL:
+                            return run(std::not_equal_to<S>());
+                        case EQUAL:
+                            return run(std::equal_to<S>());
+                    }
+                }
+            }
+    };
+}
+
+template<>
+struct Serialization<object::ParameterArray> : object::Reflected<object::ParameterArray>
+{
+    VENUS_FIELDS(object::ParameterArray, data, states)
+};
+
+// the compiled table holds parameter type ids, which follow registration order, so only whether the machine was 
+// compiled is stored and the table is rebuilt on load
+template<typename T>
+struct Serialization<object::state_machine<T>> : object::Streamed<object::state_machine<T>>
+{
+    VENUS_FIELDS(object::state_machine<T>, states, currentState, transitions, parameters)
 
+    static void write(const object::state_machine<T>& machine, object::Writer& writer)
+    {
+        writer.write(machine.compiled());
+        if(!machine.compiled())
+        {
+            object::writeFields(machine, writer, fields());
+            return;
+        }
+
+        // a compiled machine keeps its current parameter values in the table
+        object::state_machine<T> copy = machine;
+        copy.decompile();
+        object::writeFields(copy, writer, fields());
+    }
+
+    static object::state_machine<T> read(object::Reader& reader)
+    {
+        bool compiled = reader.read<bool>();
+        object::state_machine<T> result = object::readFields<object::state_machine<T>>(reader, fields());
+        if(compiled && reader.good())
+            result.compile();
         return result;
     }
 };
\ No newline at end of file
@@ -1,12 +1,54 @@
 #pragma once
 
+#include <concepts>
+#include <cstdlib>
 #include <cstring>
 #include <stdint.h>
+#include <span>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <typeinfo>
 #include <vector>
 #include <iostream>
 
+#if __has_include(<cxxabi.h>)
+    #include <cxxabi.h>
+#endif
+
+#define VENUS_PARENS ()
+#define VENUS_EXPAND(...) VENUS_EXPAND3(VENUS_EXPAND3(VENUS_EXPAND3(VENUS_EXPAND3(__VA_ARGS__))))
+#define VENUS_EXPAND3(...) VENUS_EXPAND2(VENUS_EXPAND2(VENUS_EXPAND2(VENUS_EXPAND2(__VA_ARGS__))))
+#define VENUS_EXPAND2(...) VENUS_EXPAND1(VENUS_EXPAND1(VENUS_EXPAND1(VENUS_EXPAND1(__VA_ARGS__))))
+#define VENUS_EXPAND1(...) __VA_ARGS__
+#define VENUS_MEMBERS(Type, ...) __VA_OPT__(VENUS_EXPAND(VENUS_MEMBERS_HELPER(Type, __VA_ARGS__)))
+#define VENUS_MEMBERS_HELPER(Type, field, ...) &Type::field __VA_OPT__(, VENUS_MEMBERS_AGAIN VENUS_PARENS (Type, __VA_ARGS__))
+#define VENUS_MEMBERS_AGAIN() VENUS_MEMBERS_HELPER
+
+/**
+ * @brief Declares the serialized fields of `Type`, in stream order, as a tuple of member pointers.
+ * 
+ * @details Placed inside `Type` itself (which then needs no other serialization code) or inside a 
+ *          `Serialization<Type>` specialization deriving from `object::Reflected<Type>`.
+ */
+#define VENUS_FIELDS(Type, ...) \
+    static constexpr auto fields() \
+    { \
+        return std::make_tuple(VENUS_MEMBERS(Type, __VA_ARGS__)); \
+    }
+
+/**
+ * @brief Names `Type` as it is spelled here wherever a serialized `ecs` identifies its component types.
+ * 
+ * @details Placed at global scope right after `Type` is declared, before anything registers it as a component.
+ */
+#define VENUS_NAME(Type) \
+    template<> \
+    struct object::TypeName<Type> \
+    { \
+        static constexpr const char *value = #Type; \
+    };
+
 template<typename T>
 struct Serialization
 {
@@ -17,11 +59,138 @@ struct Serialization
 
 void printSerializationError(const std::string& );
 
+namespace object
+{
+    struct Writer;
+    struct Reader;
+
+    /**
+     * @brief True for types that describe their layout with `write(const T&, Writer&)` and `read(Reader&)` members.
+     */
+    template<typename T>
+    concept MemberStreamed = requires(const T& value, Writer& writer, Reader& reader)
+    {
+        T::write(value, writer);
+        { T::read(reader) } -> std::same_as<T>;
+    };
+
+    /**
+     * @brief True for types that list their serialized fields with `VENUS_FIELDS`.
+     */
+    template<typename T>
+    concept FieldListed = requires
+    {
+        T::fields();
+    };
+
+    /**
+     * @brief Specialized for trivially copyable components holding process-local values, such as registry indices, 
+     *        so that a serialized `ecs` stores them in a portable form.
+     * 
+     * @details A specialization declares `static void write(const T&, std::vector<uint8_t>&)`, which appends the 
+     *          portable form, and `static size_t read(T&, std::vector<uint8_t>&, size_t)`, which restores it and 
+     *          returns the number of bytes read. `read` may run on a worker thread.
+     */
+    template<typename T>
+    struct Persistence {};
+
+    template<typename T>
+    concept Persisted = requires(const T& value, T& result, std::vector<uint8_t>& stream)
+    {
+        Persistence<T>::write(value, stream);
+        { Persistence<T>::read(result, stream, size_t()) } -> std::same_as<size_t>;
+    };
+
+    /**
+     * @brief Specialized through `VENUS_NAME` to give a type a name that stays the same across compilers and builds.
+     * 
+     * @details Types without a specialization are named by their demangled `typeid`, which differs between compilers 
+     *          and ABIs, so a component type stored in saved data should be named.
+     */
+    template<typename T>
+    struct TypeName {};
+
+    template<typename T>
+    concept Named = requires
+    {
+        { TypeName<T>::value } -> std::convertible_to<const char *>;
+    };
+
+    // returns the readable form of a 'typeid' name where the compiler provides a demangler, and 'name' otherwise
+    inline std::string demangle(const char *name)
+    {
+        #if __has_include(<cxxabi.h>)
+            int status = 0;
+            char *readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            if(status == 0 && readable)
+            {
+                std::string result = readable;
+                std::free(readable);
+                return result;
+            }
+        #endif
+        return name;
+    }
+
+    template<typename T>
+    std::string typeName()
+    {
+        if constexpr(Named<T>)
+            return TypeName<T>::value;
+        else
+            return demangle(typeid(T).name());
+    }
+
+    template<typename T, typename Fields>
+    void writeFields(const T& value, Writer& writer, const Fields& fields);
+
+    /**
+     * @brief Maps a serialized container to a read-only view over its elements in the byte stream.
+     */
+    template<typename T>
+    struct View;
+
+    template<typename T>
+    struct View<std::vector<T>>
+    {
+        static_assert(std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value, "only vectors stored as a single block can be viewed");
+        using element = T;
+        using type = std::span<const T>;
+    };
+
+    template<>
+    struct View<std::string>
+    {
+        using element = char;
+        using type = std::string_view;
+    };
+
+    // written ahead of every value `Writer::writeViewable` lays out, so `view` can tell that layout from plain data
+    inline constexpr uint64_t VIEWABLE = 0x5745495653554E45;
+
+    template<typename T, typename Fields>
+    T readFields(Reader& reader, const Fields& fields);
+
+    template<typename T>
+    size_t streamedLength(const T& value);
+
+    template<typename T>
+    size_t streamedSerialize(const T& value, std::vector<uint8_t>& stream, size_t index);
+
+    template<typename T>
+    T streamedDeserialize(std::vector<uint8_t>& stream, size_t index);
+}
+
+VENUS_NAME(bool)
+
 template<typename T>
 size_t defaultLengthSetter(const T& value)
 {
     // printSerializationError("ERROR: " + std::string(typeid(T).name()) + std::string(" does not have a function to define serialization length.\n"));
-    return T::length(value);
+    if constexpr(object::MemberStreamed<T> || object::FieldListed<T>)
+        return object::streamedLength(value);
+    else
+        return T::length(value);
 }
 
 template<typename T>
@@ -31,7 +200,10 @@ template<typename T>
 size_t defaultSerialization(const T& value, std::vector<uint8_t>& stream, size_t index)
 {
     // printSerializationError("ERROR: " + std::string(typeid(T).name()) + " does not have a defined serialization function.\n");
-    return T::serialize(value, stream, index);
+    if constexpr(object::MemberStreamed<T> || object::FieldListed<T>)
+        return object::streamedSerialize(value, stream, index);
+    else
+        return T::serialize(value, stream, index);
 }
 
 template<typename T>
@@ -41,7 +213,10 @@ template<typename T>
 T defaultDeserialization(std::vector<uint8_t>& stream, size_t index)
 {
     // printSerializationError("ERROR: " + std::string(typeid(T).name()) + " does not have a defined deserialization function.\n");
-    return T::deserialize(stream, index);
+    if constexpr(object::MemberStreamed<T> || object::FieldListed<T>)
+        return object::streamedDeserialize<T>(stream, index);
+    else
+        return T::deserialize(stream, index);
 }
 
 template<typename T>
@@ -117,6 +292,501 @@ namespace object
 };
 
 
+namespace object
+{
+    /**
+     * @brief Appends serialized data to a growable buffer in a single pass.
+     * 
+     * @details Trivially copyable values are copied as-is. Any other value is written as its length followed by 
+     *          its data; the length is filled in once the value has been written, so no sizing pass is needed.
+     *          A `Writer` either fills its own buffer or writes into an existing one from a given index, growing it 
+     *          when the end is reached. A `Writer` made from `nullptr` only counts: the cursor moves as if the value 
+     *          were written, but nothing is stored, which is how the streamed `length` functions measure a value.
+     */
+    struct Writer
+    {
+        Writer() : stream(&owned) {}
+        Writer(std::vector<uint8_t>& stream__, size_t index = 0) : stream(&stream__), cursor(index) {}
+        explicit Writer(std::nullptr_t) : stream(nullptr) {}
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        template<typename T>
+        Writer& write(const T& value)
+        {
+            if constexpr(std::is_trivially_copyable<T>::value)
+            {
+                uint8_t *data = allocate(sizeof(T));
+                if(data)
+                {
+                    std::memcpy(data, &value, sizeof(T));
+                }
+            }
+            else
+            {
+                size_t header = cursor;
+                allocate(sizeof(size_t));
+
+                writeData(value);
+
+                if(stream)
+                {
+                    size_t length = cursor - header - sizeof(size_t);
+                    std::memcpy(&(*stream)[header], &length, sizeof(size_t));
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Writes `size` raw bytes without a length.
+         */
+        Writer& write(const void *data, size_t size)
+        {
+            uint8_t *result = allocate(size);
+            if(result && size)
+            {
+                std::memcpy(result, data, size);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Reserves `size` bytes at the cursor and returns their address; valid until the next write.
+         * 
+         * @details A counting `Writer` only moves the cursor and returns `nullptr`.
+         */
+        uint8_t *allocate(size_t size)
+        {
+            if(!stream)
+            {
+                cursor += size;
+                return nullptr;
+            }
+            if(cursor + size > stream->size())
+            {
+                stream->resize(cursor + size);
+            }
+            uint8_t *result = stream->data() + cursor;
+            cursor += size;
+            return result;
+        }
+
+        /**
+         * @brief Writes `value` so that its elements can later be read in place with `object::view` or `Reader::view`.
+         * 
+         * @details The `VIEWABLE` tag is written first, then zero padding so that the elements land on a multiple of 
+         *          their alignment, then the value. The returned index is where the tag starts; the layout is only 
+         *          understood by `view`, which rejects data that does not start with the tag.
+         */
+        template<typename T>
+        size_t writeViewable(const T& value)
+        {
+            size_t index = cursor;
+            write(VIEWABLE);
+            align(alignof(typename View<T>::element), 2 * sizeof(size_t));
+            write(value);
+            return index;
+        }
+
+        /**
+         * @brief Pads with zeros until `ahead` bytes past the cursor is a multiple of `alignment`.
+         */
+        Writer& align(size_t alignment, size_t ahead = 0)
+        {
+            size_t padding = (alignment - (cursor + ahead) % alignment) % alignment;
+            uint8_t *data = allocate(padding);
+            if(data && padding)
+            {
+                std::memset(data, 0, padding);
+            }
+            return *this;
+        }
+
+        size_t position() const
+        {
+            return cursor;
+        }
+
+        std::vector<uint8_t>& bytes()
+        {
+            return stream ? *stream : owned;
+        }
+
+        private:
+            std::vector<uint8_t> owned;
+            std::vector<uint8_t> *stream;
+            size_t cursor = 0;
+
+            template<typename T>
+            void writeData(const T& value)
+            {
+                if constexpr(requires { Serialization<T>::write(value, *this); })
+                {
+                    Serialization<T>::write(value, *this);
+                }
+                else if constexpr(MemberStreamed<T>)
+                {
+                    T::write(value, *this);
+                }
+                else if constexpr(FieldListed<T>)
+                {
+                    writeFields(value, *this, T::fields());
+                }
+                else
+                {
+                    // types that only provide `length` and `serialize`; a counting writer needs the length alone
+                    size_t length = Serialization<T>::length(value);
+                    size_t index = cursor;
+                    allocate(length);
+                    if(stream)
+                    {
+                        Serialization<T>::serialize(value, *stream, index);
+                    }
+                }
+            }
+    };
+
+    /**
+     * @brief Reads data written by a `Writer` (or by `object::serialize`) from a bounded range of a buffer.
+     * 
+     * @details Reading past `end` does not touch memory outside the range; the `Reader` is marked as failed and 
+     *          default values are returned from then on. Lengths stored in the data are checked against the 
+     *          remaining range before anything is allocated.
+     */
+    struct Reader
+    {
+        Reader(std::vector<uint8_t>& stream__, size_t index = 0) : stream(stream__), cursor(index), end(stream__.size()) {}
+        Reader(std::vector<uint8_t>& stream__, size_t index, size_t end__) : stream(stream__), cursor(index), end(std::min(end__, stream__.size())) {}
+
+        template<typename T>
+        T read()
+        {
+            if constexpr(std::is_trivially_copyable<T>::value)
+            {
+                T result{};
+                const uint8_t *data = take(sizeof(T));
+                if(data)
+                {
+                    std::memcpy((void *)&result, data, sizeof(T));
+                }
+                return result;
+            }
+            else
+            {
+                // the stored length is not trusted; `object::serialize` does not always write it
+                if(!take(sizeof(size_t)))
+                {
+                    return T();
+                }
+                return readData<T>();
+            }
+        }
+
+        /**
+         * @brief Returns a view into the stream over a value written by `Writer::writeViewable`, without copying it.
+         * 
+         * @details The view is only valid while the stream is alive and unchanged. An empty view is returned, and the 
+         *          `Reader` marked as failed, if the data was not written by `writeViewable`, is out of range, or its 
+         *          elements are not aligned in memory.
+         */
+        template<typename T>
+        typename View<T>::type view()
+        {
+            using E = typename View<T>::element;
+
+            if(read<uint64_t>() != VIEWABLE)
+            {
+                failed = true;
+                return {};
+            }
+
+            align(alignof(E), 2 * sizeof(size_t));
+            size_t length = read<size_t>();
+            size_t size = read<size_t>();
+            if(!fits(size, sizeof(E)) || length != sizeof(size_t) + size * sizeof(E))
+            {
+                failed = true;
+                return {};
+            }
+
+            const uint8_t *data = take(size * sizeof(E));
+            if(!data || reinterpret_cast<uintptr_t>(data) % alignof(E))
+            {
+                failed = true;
+                return {};
+            }
+            return typename View<T>::type(reinterpret_cast<const E *>(data), size);
+        }
+
+        /**
+         * @brief Skips the padding `Writer::align` writes for the same arguments.
+         */
+        Reader& align(size_t alignment, size_t ahead = 0)
+        {
+            take((alignment - (cursor + ahead) % alignment) % alignment);
+            return *this;
+        }
+
+        /**
+         * @brief Returns the address of the next `size` bytes and moves past them, or `nullptr` if they are out of range.
+         */
+        const uint8_t *take(size_t size)
+        {
+            if(failed || cursor > end || size > end - cursor)
+            {
+                failed = true;
+                return nullptr;
+            }
+            const uint8_t *result = stream.data() + cursor;
+            cursor += size;
+            return result;
+        }
+
+        /**
+         * @brief Whether `count` items of `size` bytes could still fit in the remaining range.
+         */
+        bool fits(size_t count, size_t size)
+        {
+            if(failed || cursor > end || (size && count > (end - cursor) / size))
+            {
+                failed = true;
+                return false;
+            }
+            return true;
+        }
+
+        size_t position() const
+        {
+            return cursor;
+        }
+
+        size_t remaining() const
+        {
+            return end - cursor;
+        }
+
+        bool good() const
+        {
+            return !failed;
+        }
+
+        private:
+            std::vector<uint8_t>& stream;
+            size_t cursor, end;
+            bool failed = false;
+
+            template<typename T>
+            T readData()
+            {
+                if constexpr(requires { { Serialization<T>::read(*this) } -> std::same_as<T>; })
+                {
+                    return Serialization<T>::read(*this);
+                }
+                else if constexpr(requires { { T::read(*this) } -> std::same_as<T>; })
+                {
+                    return T::read(*this);
+                }
+                else if constexpr(FieldListed<T>)
+                {
+                    return readFields<T>(*this, T::fields());
+                }
+                else
+                {
+                    // `deserialize` has no end to check against, so it could read past the range this reader guards
+                    static_assert(sizeof(T) == 0, "a type read by object::Reader must provide a checked `read(Reader&)`");
+                    return T();
+                }
+            }
+    };
+
+    /**
+     * @brief Provides the `length`, `serialize` and `deserialize` functions of a `Serialization` specialization 
+     *        from its `write` and `read` functions.
+     */
+    template<typename T>
+    struct Streamed
+    {
+        static size_t length(const T& value)
+        {
+            Writer writer(nullptr);
+            Serialization<T>::write(value, writer);
+            return writer.position();
+        }
+
+        static size_t serialize(const T& value, std::vector<uint8_t>& stream, size_t index)
+        {
+            Writer writer(stream, index);
+            Serialization<T>::write(value, writer);
+            return writer.position() - index;
+        }
+
+        static T deserialize(std::vector<uint8_t>& stream, size_t index)
+        {
+            Reader reader(stream, index);
+            return Serialization<T>::read(reader);
+        }
+    };
+
+    /**
+     * @brief Writes each field of `value` in order.
+     * 
+     * @details Runs of trivially copyable fields that sit next to each other in memory, with no padding between 
+     *          them, are copied with a single `memcpy`. The stream holds the same bytes as writing each field alone.
+     */
+    template<typename T, typename Fields>
+    void writeFields(const T& value, Writer& writer, const Fields& fields)
+    {
+        const uint8_t *run = nullptr;
+        size_t length = 0;
+
+        auto flush = [&]()
+        {
+            writer.write(run, length);
+            length = 0;
+        };
+        auto field = [&](const auto& member)
+        {
+            using F = std::remove_cvref_t<decltype(member)>;
+            if constexpr(std::is_trivially_copyable<F>::value)
+            {
+                const uint8_t *address = reinterpret_cast<const uint8_t *>(&member);
+                if(length && run + length == address)
+                {
+                    length += sizeof(F);
+                    return;
+                }
+                flush();
+                run = address;
+                length = sizeof(F);
+            }
+            else
+            {
+                flush();
+                writer.write(member);
+            }
+        };
+
+        std::apply([&](auto... members) { (field(value.*members), ...); }, fields);
+        flush();
+    }
+
+    /**
+     * @brief Reads the fields written by `writeFields` into a default-constructed `T`.
+     */
+    template<typename T, typename Fields>
+    T readFields(Reader& reader, const Fields& fields)
+    {
+        T result = T();
+        uint8_t *run = nullptr;
+        size_t length = 0;
+
+        auto flush = [&]()
+        {
+            const uint8_t *data = reader.take(length);
+            if(data && length)
+            {
+                std::memcpy(run, data, length);
+            }
+            length = 0;
+        };
+        auto field = [&](auto& member)
+        {
+            using F = std::remove_cvref_t<decltype(member)>;
+            if constexpr(std::is_trivially_copyable<F>::value)
+            {
+                uint8_t *address = reinterpret_cast<uint8_t *>(&member);
+                if(length && run + length == address)
+                {
+                    length += sizeof(F);
+                    return;
+                }
+                flush();
+                run = address;
+                length = sizeof(F);
+            }
+            else
+            {
+                flush();
+                member = reader.read<F>();
+            }
+        };
+
+        std::apply([&](auto... members) { (field(result.*members), ...); }, fields);
+        flush();
+        return result;
+    }
+
+    /**
+     * @brief Provides every function of a `Serialization` specialization from the `VENUS_FIELDS` list it declares.
+     */
+    template<typename T>
+    struct Reflected : Streamed<T>
+    {
+        static void write(const T& value, Writer& writer)
+        {
+            writeFields(value, writer, Serialization<T>::fields());
+        }
+
+        static T read(Reader& reader)
+        {
+            return readFields<T>(reader, Serialization<T>::fields());
+        }
+    };
+
+    /**
+     * @brief Returns a read-only view of the value at `index` written by `Writer::writeViewable`; see `Reader::view`.
+     */
+    template<typename T>
+    typename View<T>::type view(std::vector<uint8_t>& stream, size_t index)
+    {
+        Reader reader(stream, index);
+        return reader.view<T>();
+    }
+
+    template<typename T>
+    void streamedWrite(const T& value, Writer& writer)
+    {
+        if constexpr(MemberStreamed<T>)
+            T::write(value, writer);
+        else
+            writeFields(value, writer, T::fields());
+    }
+
+    template<typename T>
+    T streamedRead(Reader& reader)
+    {
+        if constexpr(MemberStreamed<T>)
+            return T::read(reader);
+        else
+            return readFields<T>(reader, T::fields());
+    }
+
+    template<typename T>
+    size_t streamedLength(const T& value)
+    {
+        Writer writer(nullptr);
+        streamedWrite(value, writer);
+        return writer.position();
+    }
+
+    template<typename T>
+    size_t streamedSerialize(const T& value, std::vector<uint8_t>& stream, size_t index)
+    {
+        Writer writer(stream, index);
+        streamedWrite(value, writer);
+        return writer.position() - index;
+    }
+
+    template<typename T>
+    T streamedDeserialize(std::vector<uint8_t>& stream, size_t index)
+    {
+        Reader reader(stream, index);
+        return streamedRead<T>(reader);
+    }
+}
+
 template <>
 struct Serialization<std::string>
 {
@@ -129,41 +799,54 @@ struct Serialization<std::string>
     {
         size_t stringLength = value.size();
         size_t sizing = sizeof(size_t);
-        size_t count = 0;
 
         std::memcpy(&stream[index], &stringLength, sizing);
-        for(size_t i = 0; i<stringLength; i++)
+        if(stringLength)
         {
-            auto v = value[i];
-            count += object::serialize<char>(v, stream, index + sizing + count);
+            std::memcpy(&stream[index + sizing], value.data(), stringLength);
         }
-        return count + sizing;
+        return stringLength + sizing;
     }
 
     static std::string deserialize(std::vector<uint8_t>& stream, size_t index)
     {
-        size_t size = object::deserialize<size_t>(stream, index);
-        size_t offset = sizeof(size_t);
-        size_t count = 0;
+        size_t size;
+        std::memcpy(&size, &stream[index], sizeof(size_t));
 
-        std::string result = "";
+        return std::string((const char *)stream.data() + index + sizeof(size_t), size);
+    }
 
-        for(size_t i=0; i<size; i++)
+    static void write(const std::string& value, object::Writer& writer)
+    {
+        writer.write(value.size());
+        writer.write(value.data(), value.size());
+    }
+
+    static std::string read(object::Reader& reader)
+    {
+        size_t size = reader.read<size_t>();
+        const uint8_t *data = reader.take(size);
+        if(!data)
         {
-            auto v = object::deserialize<char>(stream, index + offset + count);
-            result += v;
-            count += object::length<char>(v);
+            return std::string();
         }
-
-        return result;
+        return std::string((const char *)data, size);
     }
 };
 
 template<typename T>
 struct Serialization<std::vector<T>>
 {
+    // elements that can be copied as a single block; `std::vector<bool>` packs its bits and must go element by element
+    static constexpr bool contiguous = std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value;
+
     static size_t length(const std::vector<T>& data)
     {
+        if constexpr(contiguous)
+        {
+            return data.size() * sizeof(T) + sizeof(size_t);
+        }
+
         size_t result = 0;
         size_t length = data.size();
         for(size_t i=0; i<length; i++)
@@ -176,36 +859,63 @@ struct Serialization<std::vector<T>>
 
     static size_t serialize(const std::vector<T>& value, std::vector<uint8_t>& stream, size_t index)
     {
-        size_t vectorLength = value.size();
-        size_t sizing = sizeof(size_t);
-        size_t count = 0;
+        object::Writer writer(stream, index);
+        write(value, writer);
+        return writer.position() - index;
+    }
 
-        std::memcpy(&stream[index], &vectorLength, sizing);
-        for(size_t i = 0; i<vectorLength; i++)
-        {
-            auto variable = value[i];
+    static std::vector<T> deserialize(std::vector<uint8_t>& stream, size_t index)
+    {
+        object::Reader reader(stream, index);
+        return read(reader);
+    }
 
-            size_t length = object::length<T>(variable);
-            object::serialize<T>(variable, stream, index + sizing + count, length);
-            count += length;
+    static void write(const std::vector<T>& value, object::Writer& writer)
+    {
+        writer.write(value.size());
+        if constexpr(contiguous)
+        {
+            writer.write(value.data(), value.size() * sizeof(T));
+        }
+        else
+        {
+            for(size_t i = 0; i < value.size(); i++)
+            {
+                writer.write<T>(value[i]);
+            }
         }
-        return count + sizing;
     }
 
-    static std::vector<T> deserialize(std::vector<uint8_t>& stream, size_t index)
+    static std::vector<T> read(object::Reader& reader)
     {
-        size_t size = object::deserialize<size_t>(stream, index);
-        size_t offset = sizeof(size_t);
-        size_t count = 0;
-
-        std::vector<T> result = std::vector<T>(size);
+        size_t size = reader.read<size_t>();
+        std::vector<T> result;
 
-        for(size_t i=0; i<size; i++)
+        // every element takes at least this many bytes, which bounds `size` before allocating
+        size_t minimum = std::is_trivially_copyable<T>::value ? sizeof(T) : sizeof(size_t);
+        if(!reader.fits(size, minimum))
         {
-            result[i] = object::deserialize<T>(stream, index + offset + count);
-            count += object::length<T>(result[i]);
+            return result;
         }
 
-        return result;
+        if constexpr(contiguous)
+        {
+            result.resize(size);
+            const uint8_t *data = reader.take(size * sizeof(T));
+            if(data && size)
+            {
+                std::memcpy(result.data(), data, size * sizeof(T));
+            }
+            return result;
+        }
+        else
+        {
+            result.reserve(size);
+            for(size_t i = 0; i < size && reader.good(); i++)
+            {
+                result.push_back(reader.read<T>());
+            }
+            return result;
+        }
     }
-};
\ No newline at end of file
+};
@@ -4,8 +4,60 @@
 #include "serialize.h"
 #include "vector.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
 #include <unordered_map>
 
+// glstate (namespace): remembers the GL state the engine last set so redundant binds and uniform uploads can be skipped :: all of these binds must go through here, or 'invalidate' has to be called afterwards
+namespace glstate
+{
+    // Counters (struct): calls passed on to GL versus calls elided because GL already held that state
+    struct Counters
+    {
+        uint64_t issued = 0, elided = 0;
+    };
+
+    void useProgram(uint32_t program);
+    void bindVertexArray(uint32_t array);
+    void bindTexture(uint32_t type, uint32_t texture);                  // binds to the active texture unit
+    void bindTexture(uint32_t unit, uint32_t type, uint32_t texture);   // 'unit' counts from 0 rather than GL_TEXTURE0
+    void activeTexture(uint32_t unit);
+    void bindFramebuffer(uint32_t target, uint32_t framebuffer);
+    void depthMask(bool enabled);
+    void depthTest(bool enabled);
+
+    // returns whether 'value' differs from the last one uploaded to 'location' of the current program and caches it if so
+    bool uniform(int location, const void *value, uint32_t size);
+
+    void invalidate();   // forgets everything, e.g. after deleting GL objects whose names may be reused
+    Counters& counters();
+};
+
+// UniformId (struct): FNV-1a hash of a uniform name :: string literals are hashed at compile time, and Shader resolves the hash through the location table it builds when linking
+struct UniformId
+{
+    uint32_t hash = 0;
+
+    consteval UniformId(const char *name) : hash(of(name)) {}
+
+    static constexpr uint32_t of(std::string_view name)
+    {
+        uint32_t value = 2166136261u;
+        for(char character : name)
+        {
+            value ^= (uint8_t)character;
+            value *= 16777619u;
+        }
+        return value;
+    }
+};
+
 // shader (struct): wrapper for graphical shader data :: allows for .hlsl files to be updated and used
 struct Shader
 {
@@ -20,14 +72,16 @@ struct Shader
     void remove() const;
     void setUniforms(const std::vector<std::string>& names, std::vector<int *>& results) const;
     
-    void setBool(const std::string &name, bool value) const;  
-    void setInt(const std::string &name, int32_t value) const;   
-    void setFloat(const std::string &name, float value) const;
-    void setVec2(const std::string &name, const Vector2 &vec2) const;
-    void setVec3(const std::string &name, const Vector3 &vec3) const;
-    void setColor3(const std::string &name, const Color &vec3) const;
-    void setVec4(const std::string &name, const Color &vec4) const;
-    void setMat4(const std::string &name, const float *, bool) const;
+    int location(UniformId id) const;   // -1 when the program has no active uniform by that name
+
+    void setBool(UniformId id, bool value) const;
+    void setInt(UniformId id, int32_t value) const;
+    void setFloat(UniformId id, float value) const;
+    void setVec2(UniformId id, const Vector2 &vec2) const;
+    void setVec3(UniformId id, const Vector3 &vec3) const;
+    void setColor3(UniformId id, const Color &vec3) const;
+    void setVec4(UniformId id, const Color &vec4) const;
+    void setMat4(UniformId id, const float *, bool) const;
 
     void setBool(int loc, bool value) const;  
     void setInt(int loc, int32_t value) const;   
@@ -40,11 +94,17 @@ struct Shader
 
     static void load(const std::string& path, const Shader& shader);
     static Shader &get(const std::string& path);
+    static void bindBlock(const std::string& name, uint32_t binding);   // attaches the uniform block 'name' of every loaded shader that declares it to 'binding'
     static void clear();
 
     private:
         uint32_t compileShader(const std::string &contents, uint32_t type) const;
+        void reflect() const;
+        int find(uint32_t hash) const;
+
         inline static std::unordered_map<std::string, Shader> loadedShaders;
+        inline static std::shared_mutex registry;  // guards 'loadedShaders', which BUILD reads on the loader's worker
+        inline static std::unordered_map<uint64_t, int32_t> locations;   // (program << 32 | name hash) -> location, filled by 'reflect' after linking
 };
 
 
@@ -56,71 +116,121 @@ struct Vertex
     Vector2 uv;
 };
 
-// Mesh (struct): wrapper for the Vertex Array Object and Vertex Buffer Object necessary to render a mesh
-struct Mesh
+// CompactVertex (struct): 16-byte form of Vertex :: positions are quantized to 16 bits within the mesh bounds, normals stored as signed 10:10:10:2, and uvs as half floats
+struct CompactVertex
 {
-    static size_t length(const Mesh& data)
-    {        
-        return 
-            object::length(data.vertices) + 
-            object::length(data.VAO) + 
-            object::length(data.VBO) + 
-            object::length(data.dimensions) +
-            object::length(data.offset);
-    }
+    uint16_t position[4];
+    uint32_t normal;
+    uint16_t uv[2];
+};
 
-    static size_t serialize(const Mesh& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
+// Instance (struct): per-instance attributes read by the instanced vertex shaders :: model matrix rows, color, scale and flip, uv offset and scale, material strengths
+struct Instance
+{
+    mat4x4 model;
+    Color color;
+    Vector3 scale;
+    float flip = 0;
+    Vector2 offset, uvScale = 1;
+    // read by the vertex shaders as 'aMaterial' :: a shader without lighting may give the slots its own meaning, and the ComplexRenderer passes a Fade's rate in 'ambient' and distance in 'diffuse' to "fade_shader"
+    float ambient = 0, diffuse = 0, specular = 0, shine = 0;
+
+    Instance() {}
+    Instance(const mat4x4& model__, const Vector3& scale__, const Color& color__, const Vector2& offset__ = 0, const Vector2& uvScale__ = 1, bool flip__ = false) : model(model__), color(color__), scale(scale__), flip(flip__), offset(offset__), uvScale(uvScale__) {}
+};
+
+// MeshHandle (struct): index of a Mesh in the mesh registry :: lets components share a mesh without copying its vertices
+struct MeshHandle
+{
+    static constexpr uint32_t NONE = UINT32_MAX; // the handle of a Model without a mesh, which draws nothing
 
-        count += object::serialize(value.vertices, stream, index + count);
-        count += object::serialize(value.VAO, stream, index + count);
-        count += object::serialize(value.VBO, stream, index + count);
-        count += object::serialize(value.dimensions, stream, index + count);
-        count += object::serialize(value.offset, stream, index + count);
+    uint32_t id = NONE;
+
+    bool operator==(const MeshHandle& comparison) const
+    {
+        return id == comparison.id;
+    }
 
-        return count;
+    bool operator!=(const MeshHandle& comparison) const
+    {
+        return id != comparison.id;
     }
+};
 
-    static Mesh deserialize(std::vector<uint8_t>& stream, size_t index)
+// GeometryPool (struct): one vertex buffer, index buffer, and Vertex Array Object shared by every mesh of a vertex layout :: meshes sub-allocate ranges and draw with a base vertex, so moving between them rebinds nothing
+struct GeometryPool
+{
+    // Range (struct): a block of 'count' elements starting at element 'first' of one of the pool's buffers
+    struct Range
     {
-        Mesh result = Mesh();
-        size_t count = 0;
+        uint32_t first = 0, count = 0;
+    };
 
-        result.vertices = object::deserialize<std::vector<Vertex>>(stream, index + count);
-        count += object::length(result.vertices);
+    uint32_t VAO = 0;
 
-        result.VAO = object::deserialize<uint32_t>(stream, index + count);
-        count += object::length(result.VAO);
+    void initialize(uint32_t vertexSize, void (*layout)());   // 'layout' describes the vertex attributes of the bound vertex buffer
+    void remove();
 
-        result.VBO = object::deserialize<uint32_t>(stream, index + count);
-        count += object::length(result.VBO);
+    Range allocate(bool index, uint32_t count);     // grows the buffer when no free block is large enough
+    void write(bool index, Range range, const void *data);
+    void free(bool index, Range range);
 
-        result.dimensions = object::deserialize<Vector3>(stream, index + count);
-        count += object::length(result.dimensions);
+    private:
+        // Arena (struct): a GL buffer and its free blocks, keyed by first element
+        struct Arena
+        {
+            uint32_t buffer = 0, elementSize = 0, capacity = 0;
+            std::map<uint32_t, uint32_t> blocks;
+        };
 
-        result.offset = object::deserialize<Vector3>(stream, index + count);
-        count += object::length(result.offset);
+        Arena arenas[2];    // vertices, indices
+        void (*layout)() = nullptr;
 
+        void grow(bool index, uint32_t count);
+};
+
+// Mesh (struct): a range of vertices and indices in the GeometryPool of its vertex layout :: vertices are deduplicated and drawn through indices
+struct Mesh
+{
+    // 'id' is only unique within this process, so a loaded mesh is given a new one
+    VENUS_FIELDS(Mesh, vertices, indices, packed, compacted, boundsMin, boundsSize, dimensions, offset)
+
+    static void write(const Mesh& mesh, object::Writer& writer)
+    {
+        object::writeFields(mesh, writer, fields());
+    }
+    static Mesh read(object::Reader& reader)
+    {
+        Mesh result = object::readFields<Mesh>(reader, fields());
+        result.generate();
         return result;
     }
 
-
     Mesh() {}
     Mesh(const std::vector<Vector3> &vertices__, const std::vector<float> &texture__, const Vector3& dimensions__, const Vector3& offset__ = 0) : offset(offset__)
     {
         reinit(vertices__, texture__, dimensions__);
     }
-    Mesh(const std::vector<Vertex> &vertices__, const Vector3& dimensions__, const Vector3& offset__ = 0) : vertices(vertices__), dimensions(dimensions__), offset(offset__) {}
+    Mesh(const std::vector<Vertex> &vertices__, const Vector3& dimensions__, const Vector3& offset__ = 0) : vertices(vertices__), dimensions(dimensions__), offset(offset__)
+    {
+        index();
+    }
 
-    void generate();
+    void generate();    // gives the mesh its own identity, so its next refresh allocates fresh ranges instead of replacing the ones it was copied with
+    void index();       // merges identical vertices of a triangle list into indexed triangles, ordered for the post-transform vertex cache
+    void compact();     // switches the mesh to CompactVertex :: its positions only decode through 'place', so it must be drawn via the RenderQueue
+    void place(Instance& instance) const;   // folds the compact position decode into the instance's translation and scale
     void reinit(const std::vector<Vector3> &vertices__, const std::vector<float> &texture__, const Vector3& dimensions__);
-    void refresh();
+    void refresh();     // uploads the mesh if it changed since its last upload :: meshes shared by many models upload once
     void draw(const uint32_t texture) const;
+    void drawInstanced(const uint32_t instances, size_t first, uint32_t amount) const;  // expects the texture to be bound already
     void remove();
-    void append(const std::vector<Vertex> &buffer, const Vector3& position, const Quaternion &rotation, const Quaternion &parentRotation, const Vector2& uvScale, const Vector2& uvOffset)
+    void append(const Mesh& source, const Vector3& position, const Quaternion &rotation, const Quaternion &parentRotation, const Vector2& uvScale, const Vector2& uvOffset)
     {
-        for(auto vertex : buffer)
+        uint32_t base = vertices.size();
+        packed.clear();
+        uploaded = false;
+        for(auto vertex : source.vertices)
         {
             vertex.position = (mat4x4)rotation * (mat4x4)parentRotation * vertex.position;
             vertex.position += position;
@@ -128,31 +238,69 @@ struct Mesh
             vertex.uv = vertex.uv * uvScale + uvOffset;
             vertices.push_back(vertex);
         }
+        for(uint32_t index : source.indices)
+        {
+            indices.push_back(base + index);
+        }
     }
     std::string identifier() const
     {
-        return "Mesh:"+std::to_string(VAO)+":"+std::to_string(VBO);
+        return "Mesh:"+std::to_string(id);
     }
 
     std::vector<Vertex> getVertices()
     {
         return vertices;
     }
+    std::vector<uint32_t> getIndices()
+    {
+        return indices;
+    }
 
-    static Mesh &load(const std::string &path);
+    // frees the CPU copy of the vertices and indices :: the mesh still draws from its uploaded buffers, but can no longer be refreshed or appended to
+    void release()
+    {
+        std::vector<Vertex>().swap(vertices);
+        std::vector<uint32_t>().swap(indices);
+        std::vector<CompactVertex>().swap(packed);
+    }
+
+    static Mesh &load(const std::string &path, bool compact = false);
     static Mesh &load(const std::string& path, const Mesh& mesh);
     static void load(const std::string &path, const std::vector<std::string> &subPaths, const std::string &type);
-    static void set(const std::string& path, const Mesh& mesh);
+    static MeshHandle set(const std::string& path, const Mesh& mesh);
     static Mesh &get(const std::string &path);
+    static Mesh &get(MeshHandle handle);
     static std::vector<Mesh> get(const std::string &path, const std::vector<std::string> &subPaths, const std::string &type);
+    static MeshHandle handle(const std::string &path);
+    // returns the path 'handle' was registered under, or an empty string for a missing handle
+    static std::string path(MeshHandle handle);
     static void clear();
     static bool contains(const std::string& path);
 
     private:
         std::vector<Vertex> vertices;
-        uint32_t VAO, VBO;
+        std::vector<uint32_t> indices;
+        std::vector<CompactVertex> packed;  // rebuilt from 'vertices' whenever they change
+        // Allocation (struct): where the last refresh uploaded the mesh :: copies share it until one of them changes, and the last one removed frees it
+        struct Allocation
+        {
+            GeometryPool::Range vertices, indices;
+        };
+        std::shared_ptr<Allocation> allocation;
+        uint32_t id = -1;
+        bool compacted = false, uploaded = false;
+        Vector3 boundsMin, boundsSize;
+
+        GeometryPool& pool() const;
         
-        inline static std::unordered_map<std::string, Mesh> loadedMeshes;
+        // meshes never move once loaded, so handles and references into the registry stay valid
+        inline static std::deque<Mesh> loadedMeshes;
+        inline static std::unordered_map<std::string, uint32_t> meshIds;
+        inline static std::vector<std::string> meshPaths;
+        inline static std::shared_mutex registry;  // guards 'meshIds' and 'meshPaths', which are read when a serialized world is loaded on a worker
+        inline static GeometryPool pools[2];    // full and compact vertex layouts
+        inline static std::atomic<uint32_t> nextId = 0;   // meshes may be generated while a world loads on a worker
     
     public:
         Vector3 dimensions, offset;
@@ -189,6 +337,13 @@ struct Texture
     static uint32_t filterToModifier(Filter filter);
 
 
+    // Image (struct): decoded pixel data that has not yet been uploaded to the GPU
+    struct Image
+    {
+        std::vector<uint8_t> pixels;
+        int32_t width = 0, height = 0, channels = 0;
+    };
+
     uint32_t texture;
     Vector2I resolution;
 
@@ -197,6 +352,8 @@ struct Texture
 
     static void loadAll(const std::string& directory, Filter filter = Filter::LINEAR);
     static void load(const std::string &path, Type type, Filter filter = Filter::LINEAR);
+    static Image decode(const std::string &path);
+    static void upload(const std::string &path, const Image& image, Type type, Filter filter = Filter::LINEAR);
     static void load(const std::string &path, const std::vector<std::string> &subPaths, Type type);
     static void load(const std::string& name, const std::vector<char>& data, float width, float height, Channel channel, Type type);
     static void load(const std::string& name, const std::vector<Color8>& data, float width, float height, Channel channel, Type type, Filter filter = Filter::LINEAR);
@@ -217,6 +374,7 @@ struct Texture
 
     private:
         inline static std::unordered_map<std::string, Texture> loadedTextures;
+        inline static std::shared_mutex registry;  // guards 'loadedTextures', which BUILD reads on the loader's worker
 };
 
 //
@@ -224,10 +382,28 @@ struct Animation2D
 {
     std::vector<Texture> frames;
     uint32_t currentFrame = 0;
+    float rate = 50;     // frames per second
+    float elapsed = 0;   // seconds the current frame has been shown
 
-    Animation2D(std::vector<Texture> frames__ = std::vector<Texture>())
+    Animation2D(std::vector<Texture> frames__ = std::vector<Texture>(), float rate__ = 50)
     {
         frames = frames__;
+        rate = rate__;
+    }
+
+    // advances the animation by 'seconds' :: returns whether the frame changed
+    bool update(float seconds)
+    {
+        if(frames.size() == 0 || rate <= 0)
+            return false;
+
+        elapsed += seconds;
+        uint32_t steps = elapsed * rate;
+        elapsed -= steps / rate;
+
+        uint32_t last = currentFrame;
+        currentFrame = (currentFrame + steps) % frames.size();
+        return currentFrame != last;
     }
 
     Texture current()
@@ -248,36 +424,173 @@ struct AnimationUV
 
     Vector2I bounds;
     Texture texture;
-    uint32_t length, currentFrame = 0, rate = 0;
+    uint32_t length, currentFrame = 0;
+    float rate = 0;     // frames per second
+    float elapsed = 0;  // seconds the current frame has been shown
     Type type;
 
-    AnimationUV(Texture texture__ = Texture(), uint32_t length__ = 0, uint32_t rate__ = 10, Type type__ = LOOP)
+    AnimationUV(Texture texture__ = Texture(), uint32_t length__ = 0, float rate__ = 5, Type type__ = LOOP)
     {
         texture = texture__;
         length = length__;
         rate = rate__;
         type = type__;
+        bounds = gridFor(length);
+    }
+
+    // advances the animation by 'seconds' :: returns whether the frame changed
+    bool update(float seconds)
+    {
+        if(length == 0 || rate <= 0)
+            return false;
+
+        elapsed += seconds;
+        uint32_t steps = elapsed * rate;
+        elapsed -= steps / rate;
+
+        uint32_t last = currentFrame;
+        currentFrame = type == STOP ? std::min(currentFrame + steps, length - 1) : (currentFrame + steps) % length;
+        return currentFrame != last;
+    }
+
+    Vector2 scale() const
+    {
+        return scaleFor(bounds);
+    }
+
+    Vector2 offset() const
+    {
+        return offsetFor(bounds, currentFrame);
+    }
 
+    // the smallest near-square grid holding 'length' frames
+    static Vector2I gridFor(uint32_t length)
+    {
         uint32_t square = std::ceil(std::sqrt(length));
         bool offset = (square * square - length) >= square; 
-        bounds = Vector2I(square, square - (uint32_t)offset);
+        return Vector2I(square, square - (uint32_t)offset);
+    }
+
+    static Vector2 scaleFor(const Vector2I& bounds)
+    {
+        return Vector2(1.0f / bounds.x, 1.0f / bounds.y);
     }
 
-    bool update()
+    // frames are laid out left to right, from the top row down
+    static Vector2 offsetFor(const Vector2I& bounds, uint32_t frame)
     {
-        frameCount = (frameCount + 1) % rate;
-        return !frameCount;
+        return Vector2((frame % bounds.x) / (float)bounds.x, (bounds.y - (int)(frame / bounds.x) - 1) / (float)bounds.y);
     }
+};
+
+// AnimationFrame (struct): the texture and texture coordinates of one sampled frame
+struct AnimationFrame
+{
+    Texture texture;
+    Vector2 offset = 0, scale = 1;
+};
+
+// AnimationClip (struct): an immutable list of frames stored once and shared by every entity that plays it
+struct AnimationClip
+{
+    std::vector<Texture> frames;
+    float rate = 50;  // frames per second
+    bool loop = true; // otherwise the last frame is held
+
+    // a sprite sheet clip plays 'length' frames laid out in a 'bounds' grid on 'frames[0]'
+    Vector2I bounds = Vector2I(1, 1);
+    uint32_t length = 0;
+
+    static AnimationClip sheet(const Texture& texture, uint32_t length, float rate, bool loop = true)
+    {
+        AnimationClip clip;
+        clip.frames = {texture};
+        clip.rate = rate;
+        clip.loop = loop;
+        clip.length = length;
+        clip.bounds = AnimationUV::gridFor(length);
+        return clip;
+    }
+
+    uint32_t count() const
+    {
+        return length ? length : frames.size();
+    }
+
+    // returns the index of the frame shown 'time' seconds into the clip
+    uint32_t frame(float time) const
+    {
+        uint32_t frames = count();
+        if(frames == 0)
+            return 0;
+
+        int64_t index = (int64_t)std::floor(time * rate);
+        if(!loop)
+            return std::clamp<int64_t>(index, 0, frames - 1);
+        index %= (int64_t)frames;
+        return index < 0 ? index + frames : index;
+    }
+
+    AnimationFrame sample(uint32_t frame) const
+    {
+        if(frames.size() == 0)
+            return AnimationFrame();
+        if(!length)
+            return {frames[frame]};
+        return {frames[0], AnimationUV::offsetFor(bounds, frame), AnimationUV::scaleFor(bounds)};
+    }
+
+    static AnimationClip from(const Animation2D& animation)
+    {
+        AnimationClip clip;
+        clip.frames = animation.frames;
+        clip.rate = animation.rate;
+        return clip;
+    }
+
+    static AnimationClip from(const AnimationUV& animation)
+    {
+        return sheet(animation.texture, animation.length, animation.rate, animation.type == AnimationUV::LOOP);
+    }
+
+    bool operator==(const AnimationClip& comparison) const
+    {
+        return frames == comparison.frames && rate == comparison.rate && loop == comparison.loop && 
+               bounds.x == comparison.bounds.x && bounds.y == comparison.bounds.y && length == comparison.length;
+    }
+
+    // registers 'clip' and returns the id entities refer to it by
+    static uint32_t create(const AnimationClip& clip);
+    // returns the id of a registered clip equal to 'clip', registering it if there is none
+    static uint32_t intern(const AnimationClip& clip);
+    static const AnimationClip& get(uint32_t id);
+    static void clear();
 
     private:
-        uint32_t frameCount = 0;
+        inline static std::vector<AnimationClip> loadedClips;
+};
+
+// ClipAnimator (struct): an entity's playback of an AnimationClip :: trivially copyable, so advancing it never serializes
+struct ClipAnimator
+{
+    static constexpr uint32_t NONE = UINT32_MAX; // the clip id of an animator that plays nothing
+
+    uint32_t clip = NONE;
+    float time = 0, speed = 1;
+    uint32_t frame = NONE;   // the frame last written to the entity's Model
+    uint32_t machine = NONE; // the Scene::machines batch that chooses 'clip', if any
+    uint32_t instance = NONE; // this entity's row in that batch
+
+    ClipAnimator(uint32_t clip__ = NONE, float speed__ = 1) : clip(clip__), speed(speed__) {}
 };
+VENUS_NAME(ClipAnimator)
 
 // file (namespace)
 namespace file
 {
-    // loads .obj file at 'filename' :: applied textures will be applied in a checkerboard pattern of size 'tiling'
-    Mesh loadObjFile(const std::string &fileName);
+    // loads .obj file at 'filename' :: applied textures will be applied in a checkerboard pattern of size 'tiling', and the mesh is stored as CompactVertex if 'compact' is set, 
+    // which limits it to being drawn through the RenderQueue
+    Mesh loadObjFile(const std::string &fileName, bool compact = false);
 
     std::vector<char> loadPNG(const std::string &fileName);
 }
@@ -1,7 +1,13 @@
 #pragma once
 
 #include "serialize.h"
+#include <algorithm>
+#include <atomic>
 #include <climits>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <typeinfo>
 
 // #define ECS_DEBUG_OFF
 
@@ -25,11 +31,11 @@ namespace object
             {
                 int32_t priority = 0;
 
-                bool initialized;                                       /** @brief Tracks whether the `System` has been fully initialized.*/
+                bool initialized = false;                               /** @brief Tracks whether the `System` has been fully initialized.*/
                 std::vector<uint8_t> instance;                          /** @brief The raw static instance data.*/
                 
                 std::vector<SystemFunction> functions; /** @brief Various user-defined or default functions that can be run on the `System`.*/
-                std::vector<SystemFunction> functionBuffer;
+                bool *schedule = nullptr;              /** @brief Flag of the owning `SystemManager` that is raised whenever a function is set, enabled, or disabled.*/
 
 
                 static size_t length(const system& data)
@@ -53,17 +59,17 @@ namespace object
 
                 static system deserialize(std::vector<uint8_t>& stream, size_t index)
                 {
-                    system result = system();
-                    size_t count = 0;
-
-                    result.priority = object::deserialize<int32_t>(stream, index + count);
-                    count += object::length(result.priority);
+                    object::Reader reader(stream, index);
+                    return read(reader);
+                }
 
-                    result.initialized = object::deserialize<bool>(stream, index + count);
-                    count += object::length(result.initialized);
+                static system read(object::Reader& reader)
+                {
+                    system result = system();
 
-                    result.instance = object::deserialize<std::vector<uint8_t>>(stream, index + count);
-                    count += object::length(result.instance);
+                    result.priority = reader.read<int32_t>();
+                    result.initialized = reader.read<bool>();
+                    result.instance = reader.read<std::vector<uint8_t>>();
 
                     return result;
                 }
@@ -79,7 +85,6 @@ namespace object
                 system(uint8_t functionSize)
                 {
                     functions = std::vector<SystemFunction>(functionSize, SystemFunction());
-                    functionBuffer = functions;
                     initialized = false;
                 }
 
@@ -124,7 +129,6 @@ namespace object
                 void createFunction()
                 {
                     functions.push_back(SystemFunction());
-                    functionBuffer.push_back(SystemFunction());
                 }
 
 
@@ -137,38 +141,34 @@ namespace object
                 void setFunction(uint8_t index, void (*function)(ecs&, system&, void *))
                 {
                     functions[index].func = function;
+                    functions[index].set = true;
+                    reschedule();
                 }
 
 
                 /**
                  * @brief Runs the user-defined or default function at a certain index.
                  * 
+                 * @details Disabled functions are skipped.
+                 * 
                  * @param index The index where the function pointer will be placed.
                  */
                 void runFunction(ecs& container, uint8_t index, void *data)
                 {
-                    functions[index].func(container, *this, data);
+                    if(functions[index].active)
+                    {
+                        functions[index].func(container, *this, data);
+                    }
                 }
 
 
                 void setActive(uint8_t index, bool state)
                 {
                     bool& current = functions[index].active;
-                    if(state && !current)
-                    {
-                        auto temp = functions[index].func;
-                        functions[index].func = functionBuffer[index].func;
-                        functionBuffer[index].func = temp;
-
-                        current = true;
-                    }
-                    else if(!state && current)
+                    if(current != state)
                     {
-                        auto temp = functions[index].func;
-                        functions[index].func = functionBuffer[index].func;
-                        functionBuffer[index].func = temp;
-
-                        current = false;
+                        current = state;
+                        reschedule();
                     }
                 }
 
@@ -176,23 +176,7 @@ namespace object
                 {
                     for(size_t i=0; i<functions.size(); i++)
                     {
-                        bool& current = functions[i].active;
-                        if(state && !current)
-                        {
-                            auto temp = functions[i].func;
-                            functions[i].func = functionBuffer[i].func;
-                            functionBuffer[i].func = temp;
-
-                            current = true;
-                        }
-                        else if(!state && current)
-                        {
-                            auto temp = functions[i].func;
-                            functions[i].func = functionBuffer[i].func;
-                            functionBuffer[i].func = temp;
-
-                            current = false;
-                        }
+                        setActive(i, state);
                     }
                 }
 
@@ -200,12 +184,9 @@ namespace object
                 {
                     for(size_t i=0 ; i<functions.size(); i++)
                     {
-                        bool& current = functions[i].active;
-                        auto temp = functions[i].func;
-                        functions[i].func = functionBuffer[i].func;
-                        functionBuffer[i].func = temp;
-                        current = !current;
+                        functions[i].active = !functions[i].active;
                     }
+                    reschedule();
                 }
 
                 bool functionActive(uint8_t index)
@@ -244,6 +225,16 @@ namespace object
                     instance.resize(object::length(inst) + sizeof(size_t));
                     object::serialize<T>(inst, instance, 0);
                 }
+
+                private:
+                    // signals the owning `SystemManager` that its dispatch lists are out of date
+                    void reschedule()
+                    {
+                        if(schedule)
+                        {
+                            *schedule = true;
+                        }
+                    }
             };
             
 
@@ -274,12 +265,29 @@ namespace object
             result.entityManager = object::deserialize<object::ecs::EntityManager>(stream, index + count);
             count += object::length(result.entityManager);
 
-            result.componentManager = object::deserialize<object::ecs::ComponentManager>(stream, index + count);
-            count += object::length(result.componentManager);
+            // the pools are moved to this program's type IDs while reading, so the bytes read are counted rather than taken from 'length'
+            // :: the value starts after the length 'object::serialize' writes before every non-trivial value
+            count += sizeof(size_t);
+            result.componentManager = ComponentManager::deserialize(stream, index + count, count);
+
+            std::vector<uint32_t>& loaded = result.componentManager.loaded;
+            result.entityManager.remap(loaded, result.componentManager.size());
+            if(std::find(loaded.begin(), loaded.end(), (uint32_t)-1) != loaded.end())
+                result.error = 8;
 
             result.systemManager = object::deserialize<object::ecs::SystemManager>(stream, index + count);
             count += object::length(result.systemManager);
 
+            for(SystemSupplement& supplement : result.systemManager.supplements)
+            {
+                for(uint32_t& requirement : supplement.requirement)
+                {
+                    if(requirement < loaded.size() && loaded[requirement] != (uint32_t)-1)
+                        requirement = loaded[requirement];
+                }
+            }
+            loaded.clear();
+
             return result;
         }
 
@@ -298,7 +306,7 @@ namespace object
             
             componentManager.update(entityManager.totalEntityCount());
             componentManager.addID();
-            entity e = entityManager.createEntity();
+            entity e = entityManager.createEntity(componentManager.size());
 
             addComponent<bool>(e, true);
 
@@ -364,6 +372,54 @@ namespace object
             }
         }
 
+        /**
+         * @brief Copies every active `Entity` of another `ecs` into this one.
+         * 
+         * @details Components are copied without knowledge of their type; systems of this `ecs` pick up the 
+         *          new entities as if their components had been added one at a time. Entity values stored inside
+         *          components are not altered, so the returned map should be used to fix them. Pools are matched
+         *          by type ID, which `deserialize` has already moved to this program's IDs for a `chunk` read from disk.
+         * 
+         * @param chunk The `ecs` whose entities are copied; it is not modified beyond creating missing pools.
+         * @return For every `Entity` of `chunk`, the `Entity` it became in this `ecs`, or `-1` if it was removed.
+         */
+        std::vector<entity> merge(ecs& chunk)
+        {
+            entity total = chunk.entityManager.totalEntityCount();
+            chunk.componentManager.update(total);
+
+            std::vector<entity> remap(total, -1);
+            uint32_t active = ComponentType<bool>::id;
+            for(entity c = 0; c < total; c++)
+            {
+                if(!chunk.entityManager.entityActive(c))
+                    continue;
+
+                entity e = createEntity();
+                remap[c] = e;
+
+                std::vector<bool>& bitmap = chunk.entityManager.getBitmap(c);
+                for(uint32_t cid = 0; cid < chunk.componentManager.size(); cid++)
+                {
+                    size_t index = chunk.componentManager.indexMaps[cid][c];
+                    if(cid == active || index == (size_t)-1)
+                        continue;
+
+                    componentManager.copy(e, cid, chunk.componentManager.componentArrays[cid], index);
+                    if(bitmap[cid])
+                    {
+                        addComponentConfiguration(e, cid);
+                    }
+                }
+
+                if(!chunk.active(c))
+                {
+                    setActive(e, false);
+                }
+            }
+            return remap;
+        }
+
         entity clone()
         {
             entity clone = createEntity();
@@ -373,7 +429,7 @@ namespace object
 
         size_t numberOfComponents()
         {
-            return ComponentManager::cidCount;
+            return componentRegistry().count();
         }
 
         template <typename T>
@@ -403,7 +459,7 @@ namespace object
 
             uint32_t id = ComponentType<T>::id;
             std::vector<bool>& bitmap = entityManager.getBitmap(e);
-            if(bitmap[id] == newState || !componentManager.containsComponent<T>(e))
+            if(bitmap[id] == newState || !componentManager.containsComponent<T>(e, id))
             {
                 return;
             }
@@ -439,11 +495,11 @@ namespace object
                 if(!entityManager.contains(e))
                 {
                     error = 6;
-                    return componentManager.getComponent<T>(-1, id);
+                    return componentManager.getComponent<T>(-1, id, error);
                 }
             #endif
 
-            T& result = componentManager.addComponent<T>(e, id, component);
+            T& result = componentManager.addComponent<T>(e, id, component, error);
             addComponentConfiguration(e, id);    
             return result;
         }
@@ -457,11 +513,11 @@ namespace object
                 if(!entityManager.contains(e))
                 {
                     error = 6;
-                    return componentManager.getComponent<T>(-1, id);
+                    return componentManager.getComponent<T>(-1, id, error);
                 }
             #endif
 
-            T result = componentManager.addComponent<T>(e, id, component);
+            T result = componentManager.addComponent<T>(e, id, component, error);
             addComponentConfiguration(e, id);
             
             return result;
@@ -494,7 +550,7 @@ namespace object
                 }
             #endif
 
-            componentManager.setComponent<T>(e, ComponentType<T>::id, update);
+            componentManager.setComponent<T>(e, ComponentType<T>::id, update, error);
         }
 
         template <typename T, std::enable_if_t<std::is_trivially_copyable<T>::value, int> = 0>
@@ -508,7 +564,7 @@ namespace object
                 }
             #endif
 
-            return componentManager.getComponent<T>(e, ComponentType<T>::id);
+            return componentManager.getComponent<T>(e, ComponentType<T>::id, error);
         }
 
         template <typename T, std::enable_if_t<!std::is_trivially_copyable<T>::value, int> = 0>
@@ -522,7 +578,7 @@ namespace object
                 }
             #endif
 
-            return componentManager.getComponent<T>(e, ComponentType<T>::id);
+            return componentManager.getComponent<T>(e, ComponentType<T>::id, error);
         }
 
         template <typename T, std::enable_if_t<std::is_trivially_copyable<T>::value, int> = 0>
@@ -569,10 +625,16 @@ namespace object
             #endif
 
             uint32_t id = ComponentType<T>::id;
+            if(!componentManager.containsComponent<T>(e, id))
+            {
+                error = 3;
+                return T();
+            }
+
             systemManager.componentRemoved(e, id, entityManager.getBitmap(e));
             entityManager.setComponentBit(e, id, false);
                 
-            return componentManager.removeComponent<T>(e);
+            return componentManager.removeComponent<T>(e, id, error);
         }
 
         uint8_t createSystemFunction()
@@ -685,6 +747,16 @@ namespace object
             systemManager.clearEntities();
         }
 
+        /** @brief Clears the `Entity`'s like `clearEntities`, but moves them into the returned world so they can be freed elsewhere.*/
+        ecs releaseEntities()
+        {
+            ecs result;
+            std::swap(result.entityManager, entityManager);
+            std::swap(result.componentManager, componentManager);
+            systemManager.clearEntities();
+            return result;
+        }
+
         uint32_t createSystemToggle()
         {
             return systemManager.createToggle();
@@ -709,8 +781,116 @@ namespace object
             systemManager.addToggles(index, id);
         }
 
+        /**
+         * @brief Memory held by a single component pool.
+         */
+        struct ComponentStats
+        {
+            uint32_t id;
+            const char *name;      /** @brief The type's `VENUS_NAME`, or its demangled `typeid` name.*/
+            size_t count;          /** @brief The number of stored components.*/
+            size_t bytesUsed;      /** @brief Bytes of component data, including the pool's header and default component.*/
+            size_t bytesReserved;  /** @brief Bytes allocated for component data.*/
+            size_t indexMapBytes;  /** @brief Bytes allocated for the `Entity` to component lookup.*/
+        };
+
+        /**
+         * @brief Memory held by a single `System` and its `SystemSupplement`.
+         */
+        struct SystemStats
+        {
+            uint32_t id;
+            const char *name;      /** @brief The type's `VENUS_NAME`, or its demangled `typeid` name.*/
+            size_t entities;         /** @brief The number of entities that match the `System`.*/
+            size_t instanceBytes;
+            size_t indexMapBytes;
+            size_t reverseIndexMapBytes;
+            size_t requirementBytes;
+        };
+
+        /**
+         * @brief A snapshot of the memory and occupancy of an `ecs`.
+         */
+        struct Stats
+        {
+            entity entities;         /** @brief Active entities.*/
+            entity recycledEntities; /** @brief Length of the recycle list.*/
+            size_t bitmapBytes;      /** @brief Approximate bytes held by the component bitmaps.*/
+            std::vector<ComponentStats> components;
+            std::vector<SystemStats> systems;
+        };
+
+        /**
+         * @brief Collects memory and occupancy information for every component pool and `System`.
+         * 
+         * @details Runs in time proportional to the number of component and `System` types, so it can be
+         *          called every frame.
+         */
+        Stats stats()
+        {
+            Stats result;
+            result.entities = entityManager.activeEntityCount();
+            result.recycledEntities = entityManager.totalEntityCount() - entityManager.activeEntityCount();
+            result.bitmapBytes = entityManager.totalEntityCount() * (sizeof(std::vector<bool>) + (componentManager.size() + 8) / 8);
+
+            for(uint32_t cid = 0; cid < componentManager.size(); cid++)
+            {
+                ComponentArray& array = componentManager.componentArrays[cid];
+                result.components.push_back
+                ({
+                    cid, componentRegistry().name(cid), array.count, 
+                    array.components.size(), array.components.capacity(), 
+                    componentManager.indexMaps[cid].capacity() * sizeof(size_t)
+                });
+            }
+
+            for(uint32_t id = 0; id < systemManager.stores.size(); id++)
+            {
+                SystemSupplement& supplement = systemManager.supplements[id];
+                result.systems.push_back
+                ({
+                    id, systemRegistry().name(id), supplement.reverseIndexMap.size(),
+                    systemManager.stores[id].instance.capacity(),
+                    supplement.indexMap.capacity() * sizeof(size_t),
+                    supplement.reverseIndexMap.capacity() * sizeof(entity),
+                    supplement.requirement.capacity() * sizeof(uint32_t)
+                });
+            }
+            return result;
+        }
+
+        /**
+         * @brief Formats the result of `stats()` as a JSON object.
+         */
+        std::string statsJSON()
+        {
+            Stats data = stats();
+            auto field = [](const std::string& key, size_t value)
+            {
+                return "\"" + key + "\": " + std::to_string(value);
+            };
+
+            std::string result = "{" + field("entities", data.entities) + ", " + field("recycledEntities", data.recycledEntities) + ", " + field("bitmapBytes", data.bitmapBytes) + ", \"components\": [";
+            for(size_t i = 0; i < data.components.size(); i++)
+            {
+                ComponentStats& c = data.components[i];
+                result += std::string(i ? ", " : "") + "{" + field("id", c.id) + ", \"name\": \"" + c.name + "\", " + field("count", c.count) + ", " + 
+                    field("bytesUsed", c.bytesUsed) + ", " + field("bytesReserved", c.bytesReserved) + ", " + field("indexMapBytes", c.indexMapBytes) + "}";
+            }
+
+            result += "], \"systems\": [";
+            for(size_t i = 0; i < data.systems.size(); i++)
+            {
+                SystemStats& s = data.systems[i];
+                result += std::string(i ? ", " : "") + "{" + field("id", s.id) + ", \"name\": \"" + s.name + "\", " + field("entities", s.entities) + ", " + 
+                    field("instanceBytes", s.instanceBytes) + ", " + field("indexMapBytes", s.indexMapBytes) + ", " + 
+                    field("reverseIndexMapBytes", s.reverseIndexMapBytes) + ", " + field("requirementBytes", s.requirementBytes) + "}";
+            }
+            return result + "]}";
+        }
+
         //
-        static uint16_t getError()
+        uint16_t getError()
         {
             uint16_t err = error;
             error = 0;
@@ -718,7 +898,7 @@ namespace object
         }
 
         //
-        static std::string parseError()
+        std::string parseError()
         {
             uint16_t err = getError();
             switch(err)
@@ -747,6 +927,9 @@ namespace object
                 case 7:
                     return "ERROR :: Archetypes not enabled, but an archetype-exclusive function was used.";
                 break;
+                case 8:
+                    return "ERROR :: A deserialized component type is not registered in this program; its components were dropped.";
+                break;
             }
             return "N/A.";
         }
@@ -759,6 +942,101 @@ namespace object
         }
 
         private:
+            /**
+             * @brief A thread-safe list of the sizes of every registered component or system type.
+             * 
+             * @details Types register themselves once, when their `ComponentType` or `SystemType` ID is first 
+             *          initialized; afterwards the list only grows. Every `ecs` reads from the same registry,
+             *          while all mutable data lives in the individual `ecs`, so separate worlds can be used 
+             *          from separate threads.
+             */
+            struct TypeRegistry
+            {
+                using Writer = void (*)(const uint8_t *, std::vector<uint8_t>&);
+                using Reader = size_t (*)(uint8_t *, std::vector<uint8_t>&, size_t);
+
+                uint32_t add(size_t size, bool trivial, const std::string& name, Writer write = nullptr, Reader read = nullptr)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    sizes.push_back(size);
+                    trivials.push_back(trivial);
+                    names.push_back(name);
+                    writers.push_back(write);
+                    readers.push_back(read);
+                    return total++;
+                }
+
+                Writer writer(uint32_t id) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    return writers[id];
+                }
+
+                Reader reader(uint32_t id) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    return readers[id];
+                }
+
+                uint32_t count() const
+                {
+                    return total.load(std::memory_order_acquire);
+                }
+
+                size_t size(uint32_t id) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    return sizes[id];
+                }
+
+                bool trivial(uint32_t id) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    return trivials[id];
+                }
+
+                const char *name(uint32_t id) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    return names[id].c_str();
+                }
+
+                /**
+                 * @brief Returns the ID of the type named `name`, or `-1` if no such type is registered.
+                 */
+                uint32_t find(const std::string& name) const
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    for(uint32_t id = 0; id < names.size(); id++)
+                    {
+                        if(name == names[id])
+                            return id;
+                    }
+                    return -1;
+                }
+
+                private:
+                    mutable std::mutex lock;
+                    std::vector<size_t> sizes;
+                    std::vector<bool> trivials;
+                    std::deque<std::string> names; // a deque, so the names handed out stay valid as types are added
+                    std::vector<Writer> writers;
+                    std::vector<Reader> readers;
+                    std::atomic<uint32_t> total = 0;
+            };
+
+            static TypeRegistry& componentRegistry()
+            {
+                static TypeRegistry registry;
+                return registry;
+            }
+
+            static TypeRegistry& systemRegistry()
+            {
+                static TypeRegistry registry;
+                return registry;
+            }
+
             /**
              * @brief A manager for created and destroyed `Entity` variables.
              * 
@@ -821,9 +1099,10 @@ namespace object
                  * @details Either returns and Entity with an incremented value, or recycles an Entity that 
                  *          has been deleted. Also initializes the `Entity`'s bitmap.
                  * 
+                 * @param components The number of component types the bitmap must hold.
                  * @return Newly created `Entity` 
                  */
-                entity createEntity()
+                entity createEntity(uint32_t components)
                 {
                     entity entity = entityCount++;
 
@@ -836,7 +1115,7 @@ namespace object
                     // creates a new bitmap if no entities can be recycled
                     else
                     {
-                        componentBitmaps.push_back(std::vector<bool>(ComponentManager::cidCount + 1));
+                        componentBitmaps.push_back(std::vector<bool>(components + 1));
                     }
                     componentBitmaps[entity].back() = true;
                     return entity;
@@ -852,7 +1131,7 @@ namespace object
                 void removeEntity(entity entity)
                 {
                     // resets the bitmap to be recycled
-                    componentBitmaps[entity] = std::vector<bool>(ComponentManager::cidCount + 1);
+                    componentBitmaps[entity].assign(componentBitmaps[entity].size(), false);
                     removedEntities.push_back(entity);
                     entityCount--;
                 }
@@ -880,6 +1159,26 @@ namespace object
                     return componentBitmaps[entity];
                 }
 
+                /**
+                 * @brief Moves the bit of each component type to the ID given by `remap`, as returned by `ComponentManager::localize`.
+                 * 
+                 * @param count The number of component types the new bitmaps hold.
+                 */
+                void remap(const std::vector<uint32_t>& remap, uint32_t count)
+                {
+                    for(std::vector<bool>& bitmap : componentBitmaps)
+                    {
+                        std::vector<bool> moved(count + 1);
+                        for(uint32_t cid = 0; cid + 1 < bitmap.size() && cid < remap.size(); cid++)
+                        {
+                            if(remap[cid] != (uint32_t)-1)
+                                moved[remap[cid]] = bitmap[cid];
+                        }
+                        moved.back() = bitmap.size() && bitmap.back();
+                        bitmap = std::move(moved);
+                    }
+                }
+
                 /**
                  * @brief Determines whether the given `Entity` has been removed or is still active.
                  * 
@@ -923,7 +1222,7 @@ namespace object
              */
             struct ComponentArray
             {
-                size_t count = 0;
+                size_t count = 0;                /** @brief The number of components stored in the pool.*/
                 size_t componentSize;            /** @brief The size of the component the `components` vector holds.*/
                 std::vector<uint8_t> components; /** @brief An vector of 8-bit unsigned values that holds all the component data.*/
 
@@ -931,6 +1230,7 @@ namespace object
                 static size_t length(const ComponentArray& data)
                 {
                     return 
+                        object::length(data.count) + 
                         object::length(data.componentSize) + 
                         object::length(data.components);
                 }
@@ -939,6 +1239,7 @@ namespace object
                 {
                     size_t count = 0;
 
+                    count += object::serialize(value.count, stream, index + count);
                     count += object::serialize(value.componentSize, stream, index + count);
                     count += object::serialize(value.components, stream, index + count);
 
@@ -947,14 +1248,17 @@ namespace object
 
                 static ComponentArray deserialize(std::vector<uint8_t>& stream, size_t index)
                 {
-                    ComponentArray result = ComponentArray();
-                    size_t count = 0;
+                    object::Reader reader(stream, index);
+                    return read(reader);
+                }
 
-                    result.componentSize = object::deserialize<size_t>(stream, index + count);
-                    count += object::length(result.componentSize);
+                static ComponentArray read(object::Reader& reader)
+                {
+                    ComponentArray result = ComponentArray();
 
-                    result.components = object::deserialize<std::vector<uint8_t>>(stream, index + count);
-                    count += object::length(result.components);
+                    result.count = reader.read<size_t>();
+                    result.componentSize = reader.read<size_t>();
+                    result.components = reader.read<std::vector<uint8_t>>();
 
                     return result;
                 }
@@ -981,7 +1285,7 @@ namespace object
                         offset = componentSize;
                     }
 
-                    std::memcpy(&components[index], &components[index + offset], components.size() - (index + offset));
+                    std::memmove(&components[index], &components[index + offset], components.size() - (index + offset));
                     components.resize(components.size() - offset);
 
                     return offset;
@@ -992,6 +1296,28 @@ namespace object
                     return object::deserialize<bool>(components, 0);
                 }
 
+                /**
+                 * @brief Appends a copy of a component stored in another pool of the same type.
+                 * 
+                 * @details The stored bytes are copied as-is, so the type of the component does not need to be known.
+                 * 
+                 * @param index Set to the location of the copied component.
+                 * @param source The pool that holds the original component.
+                 * @param sourceIndex The location of the original component in `source`.
+                 */
+                void copy(size_t& index, ComponentArray& source, size_t sourceIndex)
+                {
+                    size_t size = componentSize;
+                    if(source.complex())
+                    {
+                        size = object::deserialize<size_t>(source.components, sourceIndex) + sizeof(size_t);
+                    }
+
+                    index = components.size();
+                    count++;
+                    components.insert(components.end(), source.components.begin() + sourceIndex, source.components.begin() + sourceIndex + size);
+                }
+
                 /**
                  * @brief Attaches data based off a provided `Entity`.
                  * 
@@ -1005,11 +1331,11 @@ namespace object
                  * @return Reference to the component in its component pool.
                  */
                 template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
-                T& addComponent(size_t& index, const T& component);
+                T& addComponent(size_t& index, const T& component, uint16_t& error);
 
 
                 template<typename T, typename = std::enable_if_t<!std::is_trivially_copyable<T>::value>>
-                T addComponent(size_t& index, const T& component);
+                T addComponent(size_t& index, const T& component, uint16_t& error);
 
                 /**
                  * @brief Returns data based off a provided `Entity`.
@@ -1022,13 +1348,13 @@ namespace object
                  * @return Reference to the component in its component pool.
                  */
                 template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
-                T& getComponent(size_t index);
+                T& getComponent(size_t index, uint16_t& error);
 
                 template<typename T, typename = std::enable_if_t<!std::is_trivially_copyable<T>::value>>
-                T getComponent(size_t index);
+                T getComponent(size_t index, uint16_t& error);
 
                 template<typename T>
-                size_t setComponent(size_t index, const T& update);
+                size_t setComponent(size_t index, const T& update, uint16_t& error);
 
                 /**
                  * @brief Retrieves a reference to an unattached component.
@@ -1053,64 +1379,171 @@ namespace object
              */
             struct ComponentManager
             {
-                static inline uint32_t cidCount = 0; /** @brief Holds the number of registered component types.*/
-
-                static inline std::vector<size_t> spaceBuffer = {};        /** @brief A temporary vector that holds the size of each component per pool.*/
-                static inline std::vector<bool> complexBuffer = {};        /** @brief A temporary vector that stores whether a component type is copyable.*/
-
                 std::vector<ComponentArray> componentArrays; /** @brief A vector of component pools.*/
                 std::vector<std::vector<size_t>> indexMaps;
+                std::vector<uint32_t> loaded;                /** @brief Set by `deserialize` to the result of `localize`, so the owning `ecs` can move its bitmaps the same way.*/
 
 
                 static size_t length(const ComponentManager& data)
                 {
                     return 
-                        object::length(data.cidCount) +
-                        object::length(data.spaceBuffer) +
-                        object::length(data.complexBuffer) +
                         object::length(data.componentArrays) +
-                        object::length(data.indexMaps);
+                        object::length(data.indexMaps) +
+                        object::length(data.persisted()) +
+                        object::length(data.types());
                 }
 
                 static size_t serialize(const ComponentManager& value, std::vector<uint8_t>& stream, size_t index)
                 {
                     size_t count = 0;
 
-                    count += object::serialize(value.cidCount, stream, index + count);
-                    count += object::serialize(value.spaceBuffer, stream, index + count);
-                    count += object::serialize(value.complexBuffer, stream, index + count);
                     count += object::serialize(value.componentArrays, stream, index + count);
                     count += object::serialize(value.indexMaps, stream, index + count);
+                    count += object::serialize(value.persisted(), stream, index + count);
+                    count += object::serialize(value.types(), stream, index + count);
 
                     return count;
                 }
 
                 static ComponentManager deserialize(std::vector<uint8_t>& stream, size_t index)
                 {
-                    ComponentManager result = ComponentManager();
                     size_t count = 0;
+                    return deserialize(stream, index, count);
+                }
+
+                /**
+                 * @brief Reads a `ComponentManager` and adds the number of bytes read to `count`.
+                 * 
+                 * @details `length` of the result does not match what was read once its pools have been localized.
+                 */
+                static ComponentManager deserialize(std::vector<uint8_t>& stream, size_t index, size_t& count)
+                {
+                    ComponentManager result = ComponentManager();
+                    size_t read = 0;
 
-                    // STATIC: special consideration may be required
-                    result.cidCount = object::deserialize<uint32_t>(stream, index + count);
-                    count += object::length(result.cidCount);
+                    result.componentArrays = object::deserialize<std::vector<ComponentArray>>(stream, index + read);
+                    read += object::length(result.componentArrays);
 
-                    // STATIC: special consideration may be required
-                    result.spaceBuffer = object::deserialize<std::vector<size_t>>(stream, index + count);
-                    count += object::length(result.spaceBuffer);
+                    result.indexMaps = object::deserialize<std::vector<std::vector<size_t>>>(stream, index + read);
+                    read += object::length(result.indexMaps);
 
-                    // STATIC: special consideration may be required
-                    result.complexBuffer = object::deserialize<std::vector<bool>>(stream, index + count);
-                    count += object::length(result.complexBuffer);
+                    std::vector<std::vector<uint8_t>> persisted = object::deserialize<std::vector<std::vector<uint8_t>>>(stream, index + read);
+                    read += object::length(persisted);
 
-                    result.componentArrays = object::deserialize<std::vector<ComponentArray>>(stream, index + count);
-                    count += object::length(result.componentArrays);
+                    std::vector<std::string> types = object::deserialize<std::vector<std::string>>(stream, index + read);
+                    read += object::length(types);
 
-                    result.indexMaps = object::deserialize<std::vector<std::vector<size_t>>>(stream, index + count);
-                    count += object::length(result.indexMaps);
+                    // pool IDs depend on the order types were registered in the program that wrote the stream
+                    result.loaded = result.localize(types, persisted);
+                    result.restore(persisted);
 
+                    count += read;
+                    return result;
+                }
+
+                /**
+                 * @brief The name of the type held by each pool, which identifies it across programs.
+                 */
+                std::vector<std::string> types() const
+                {
+                    std::vector<std::string> result;
+                    TypeRegistry& registry = componentRegistry();
+                    for(uint32_t cid = 0; cid < size() && cid < registry.count(); cid++)
+                    {
+                        result.push_back(registry.name(cid));
+                    }
                     return result;
                 }
 
+                /**
+                 * @brief Moves every pool read from a stream to the ID its type has in this program.
+                 * 
+                 * @details Pools of types this program does not register are dropped, and pools of types the stream 
+                 *          did not hold are created empty. `persisted` is reordered along with the pools.
+                 * 
+                 * @return For each pool of the stream, the ID it moved to, or `-1` if it was dropped.
+                 */
+                std::vector<uint32_t> localize(const std::vector<std::string>& names, std::vector<std::vector<uint8_t>>& persisted)
+                {
+                    TypeRegistry& registry = componentRegistry();
+                    uint32_t count = registry.count();
+                    size_t identifiers = indexMaps.size() ? indexMaps[0].size() : 0;
+
+                    std::vector<uint32_t> result(size(), -1);
+                    std::vector<ComponentArray> arrays(count);
+                    std::vector<std::vector<size_t>> maps(count);
+                    std::vector<std::vector<uint8_t>> blobs(count);
+                    std::vector<bool> found(count, false);
+                    for(uint32_t cid = 0; cid < size() && cid < names.size(); cid++)
+                    {
+                        uint32_t id = registry.find(names[cid]);
+                        if(id == (uint32_t)-1 || found[id])
+                            continue;
+
+                        result[cid] = id;
+                        found[id] = true;
+                        arrays[id] = std::move(componentArrays[cid]);
+                        maps[id] = std::move(indexMaps[cid]);
+                        if(cid < persisted.size())
+                            blobs[id] = std::move(persisted[cid]);
+                    }
+                    for(uint32_t id = 0; id < count; id++)
+                    {
+                        if(found[id])
+                            continue;
+                        arrays[id] = ComponentArray(registry.size(id), registry.trivial(id));
+                        maps[id] = std::vector<size_t>(identifiers, (size_t)-1);
+                    }
+
+                    componentArrays = std::move(arrays);
+                    indexMaps = std::move(maps);
+                    persisted = std::move(blobs);
+                    return result;
+                }
+
+                /**
+                 * @brief The portable form of every pool whose type specializes `Persistence`, written in `Entity` order.
+                 */
+                std::vector<std::vector<uint8_t>> persisted() const
+                {
+                    std::vector<std::vector<uint8_t>> result(size());
+                    TypeRegistry& registry = componentRegistry();
+                    for(uint32_t cid = 0; cid < size() && cid < registry.count(); cid++)
+                    {
+                        TypeRegistry::Writer write = registry.writer(cid);
+                        if(!write)
+                            continue;
+
+                        for(size_t index : indexMaps[cid])
+                        {
+                            if(index != (size_t)-1)
+                                write(&componentArrays[cid].components[index], result[cid]);
+                        }
+                    }
+                    return result;
+                }
+
+                /**
+                 * @brief Restores the process-local values of every pool from the portable form written by `persisted`.
+                 */
+                void restore(std::vector<std::vector<uint8_t>>& persisted)
+                {
+                    TypeRegistry& registry = componentRegistry();
+                    for(uint32_t cid = 0; cid < size() && cid < persisted.size() && cid < registry.count(); cid++)
+                    {
+                        TypeRegistry::Reader read = registry.reader(cid);
+                        if(!read || persisted[cid].empty())
+                            continue;
+
+                        size_t offset = 0;
+                        for(size_t index : indexMaps[cid])
+                        {
+                            if(index != (size_t)-1)
+                                offset += read(&componentArrays[cid].components[index], persisted[cid], offset);
+                        }
+                    }
+                }
+
 
                 ComponentManager() {}
 
@@ -1120,19 +1553,23 @@ namespace object
                  * @details Further initializes each component pool with information 
                  *          related to the type of data they hold.
                  */
-                ComponentManager(entity identifiers) : indexMaps(cidCount, std::vector<size_t>(identifiers))
+                ComponentManager(entity identifiers)
                 {
                     componentArrays = std::vector<ComponentArray>();
-                    for(uint32_t i=0; i<cidCount; i++)
-                    {
-                        // space is allocated for an empty object of type T; this object can be used for error-handling
-                        componentArrays.push_back(ComponentArray(spaceBuffer[i], complexBuffer[i]));
-                    }
+                    update(identifiers);
+                }
+
+                /**
+                 * @return The number of component pools held by this manager.
+                 */
+                uint32_t size() const
+                {
+                    return componentArrays.size();
                 }
 
                 void addID()
                 {
-                    for(uint32_t i=0; i<cidCount; i++)
+                    for(uint32_t i=0; i<size(); i++)
                     {
                         indexMaps[i].push_back(-1);
                     }
@@ -1143,7 +1580,7 @@ namespace object
                  */
                 void removeID(entity e)
                 {
-                    for(uint32_t cid=0; cid<cidCount; cid++)
+                    for(uint32_t cid=0; cid<size(); cid++)
                     {
                         size_t index = indexMaps[cid][e];
                         if(index == (size_t)-1)
@@ -1153,14 +1590,19 @@ namespace object
                     }
                 }
 
+                /**
+                 * @brief Creates a component pool for every type registered since the last update.
+                 */
                 void update(entity identifiers)
                 {
-                    size_t size = indexMaps.size();
-                    while(size < cidCount)
+                    TypeRegistry& registry = componentRegistry();
+                    uint32_t count = registry.count();
+                    while(size() < count)
                     {
-                        indexMaps.push_back(std::vector<size_t>(identifiers));
-                        componentArrays.push_back(ComponentArray(spaceBuffer[size], complexBuffer[size]));
-                        size++;
+                        // space is allocated for an empty object of type T; this object can be used for error-handling
+                        uint32_t cid = size();
+                        indexMaps.push_back(std::vector<size_t>(identifiers, (size_t)-1));
+                        componentArrays.push_back(ComponentArray(registry.size(cid), registry.trivial(cid)));
                     }
                 }
 
@@ -1183,28 +1625,34 @@ namespace object
                  * @return Reference to the component in its component pool.
                  */
                 template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
-                T& addComponent(entity e, uint32_t cid, const T& component)
+                T& addComponent(entity e, uint32_t cid, const T& component, uint16_t& error)
                 {
                     ComponentArray& array = componentArrays[cid];
                     size_t& index = indexMaps[cid][e];
-                    T& result = array.addComponent<T>(index, component);
+                    T& result = array.addComponent<T>(index, component, error);
                     return result;
                 }
 
 
                 template<typename T, typename = std::enable_if_t<!std::is_trivially_copyable<T>::value>>
-                T addComponent(entity e, uint32_t cid, const T& component)
+                T addComponent(entity e, uint32_t cid, const T& component, uint16_t& error)
                 {
                     ComponentArray& array = componentArrays[cid];       
-                    return array.addComponent<T>(indexMaps[cid][e], component);
+                    return array.addComponent<T>(indexMaps[cid][e], component, error);
+                }
+
+                void copy(entity e, uint32_t cid, ComponentArray& source, size_t sourceIndex)
+                {
+                    componentArrays[cid].copy(indexMaps[cid][e], source, sourceIndex);
                 }
 
                 template<typename T>
                 void share(entity e, entity share, uint32_t cid)
                 {
-                    if(indexMaps[cid][e] != -1)
+                    size_t index = indexMaps[cid][e];
+                    if(index != (size_t)-1)
                     {
-                        removeComponent<T>(e);
+                        remove(cid, index, e);
                     }
                     indexMaps[cid][e] = indexMaps[cid][share];
                 }
@@ -1220,15 +1668,15 @@ namespace object
                  * @return Reference to the component in its component pool.
                  */
                 template<typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
-                T& getComponent(entity e, uint32_t cid)
+                T& getComponent(entity e, uint32_t cid, uint16_t& error)
                 {
-                    return componentArrays[cid].getComponent<T>(indexMaps[cid][e]);
+                    return componentArrays[cid].getComponent<T>(indexMaps[cid][e], error);
                 }
 
                 template<typename T, typename = std::enable_if_t<!std::is_trivially_copyable<T>::value>>
-                T getComponent(entity e, uint32_t cid)
+                T getComponent(entity e, uint32_t cid, uint16_t& error)
                 {
-                    return componentArrays[cid].getComponent<T>(indexMaps[cid][e]);
+                    return componentArrays[cid].getComponent<T>(indexMaps[cid][e], error);
                 }
 
 
@@ -1271,9 +1719,9 @@ namespace object
                  * @return Copy of the deleted component.
                  */
                 template<typename T>
-                T removeComponent(entity e, uint32_t cid)
+                T removeComponent(entity e, uint32_t cid, uint16_t& error)
                 {
-                    T result = getComponent<T>(e);
+                    T result = getComponent<T>(e, cid, error);
                     size_t index = indexMaps[cid][e];
 
                     remove(cid, index, e);
@@ -1282,15 +1730,15 @@ namespace object
                 }
                 
                 template<typename T>
-                void setComponent(entity e, uint32_t cid, const T& update)
+                void setComponent(entity e, uint32_t cid, const T& update, uint16_t& error)
                 {
                     size_t index = indexMaps[cid][e];
-                    size_t offset = componentArrays[cid].setComponent<T>(index, update);
+                    size_t offset = componentArrays[cid].setComponent<T>(index, update, error);
 
                     size_t size = indexMaps[cid].size();
                     for(size_t i=0; i<size; i++)
                     {
-                        if(indexMaps[cid][i] > index)
+                        if(indexMaps[cid][i] > index && indexMaps[cid][i] != (size_t)-1)
                             indexMaps[cid][i] += offset;
                     }
                 }
@@ -1308,11 +1756,20 @@ namespace object
                 static uint32_t newId()
                 {
                     // whenever the compiler finds a new ComponentType, this function is called
-                    uint32_t index = cidCount;
-                    spaceBuffer.push_back(sizeof(T));
-                    complexBuffer.push_back(std::is_trivially_copyable<T>());
-                    cidCount++;
-                    return index;
+                    if constexpr(Persisted<T>)
+                    {
+                        static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable components are stored as they are in memory");
+                        return componentRegistry().add(sizeof(T), true, object::typeName<T>(), 
+                        [](const uint8_t *component, std::vector<uint8_t>& stream)
+                        {
+                            Persistence<T>::write(*reinterpret_cast<const T *>(component), stream);
+                        },
+                        [](uint8_t *component, std::vector<uint8_t>& stream, size_t index)
+                        {
+                            return Persistence<T>::read(*reinterpret_cast<T *>(component), stream, index);
+                        });
+                    }
+                    return componentRegistry().add(sizeof(T), std::is_trivially_copyable<T>(), object::typeName<T>());
                 }
 
                 private:
@@ -1352,11 +1809,13 @@ namespace object
             {
                 void (*func)(ecs&, system&, void *);
                 bool active;
+                bool set;   /** @brief Tracks whether a user-defined function has replaced the default.*/
 
                 SystemFunction()
                 {
                     func = [](object::ecs&, system&, void *){};
                     active = true;
+                    set = false;
                 }
             };
 
@@ -1397,12 +1856,14 @@ namespace object
 
                 static SystemToggle deserialize(std::vector<uint8_t>& stream, size_t index)
                 {
-                    SystemToggle result = SystemToggle();
-                    size_t count = 0;
-
-                    result.functions = object::deserialize<std::vector<FunctionID>>(stream, index + count);
-                    count += object::length(result.functions);
+                    object::Reader reader(stream, index);
+                    return read(reader);
+                }
 
+                static SystemToggle read(object::Reader& reader)
+                {
+                    SystemToggle result = SystemToggle();
+                    result.functions = reader.read<std::vector<FunctionID>>();
                     return result;
                 }
 
@@ -1441,17 +1902,17 @@ namespace object
 
                 static SystemSupplement deserialize(std::vector<uint8_t>& stream, size_t index)
                 {
-                    SystemSupplement result = SystemSupplement();
-                    size_t count = 0;
-
-                    result.requirement = object::deserialize<std::vector<uint32_t>>(stream, index + count);
-                    count += object::length(result.requirement);
+                    object::Reader reader(stream, index);
+                    return read(reader);
+                }
 
-                    result.indexMap = object::deserialize<std::vector<size_t>>(stream, index + count);
-                    count += object::length(result.indexMap);
+                static SystemSupplement read(object::Reader& reader)
+                {
+                    SystemSupplement result = SystemSupplement();
 
-                    result.reverseIndexMap = object::deserialize<std::vector<uint32_t>>(stream, index + count);
-                    count += object::length(result.reverseIndexMap);
+                    result.requirement = reader.read<std::vector<uint32_t>>();
+                    result.indexMap = reader.read<std::vector<size_t>>();
+                    result.reverseIndexMap = reader.read<std::vector<uint32_t>>();
 
                     return result;
                 }
@@ -1503,26 +1964,24 @@ namespace object
 
             struct SystemManager
             {
-                static inline uint32_t idCount = 0;
-                static inline std::vector<size_t> spaceBuffer = {};
-
                 uint8_t functionIndex = 0;
 
                 std::vector<system> stores;
                 std::vector<SystemSupplement> supplements;
-                std::vector<uint32_t> indexMap;
+                std::vector<uint32_t> schedule;              /** @brief Every created `System`, ordered by priority (ties keep creation order).*/
                 std::vector<SystemToggle> toggles;
 
+                std::vector<std::vector<uint32_t>> dispatch; /** @brief Per function, the `System`s in `schedule` order that have that function set and active.*/
+                bool dispatchChanged = true;                 /** @brief Raised when `dispatch` must be rebuilt before the next run.*/
+
 
                 static size_t length(const SystemManager& data)
                 {
                     return
-                        object::length(data.idCount) +
                         object::length(data.functionIndex) +
-                        object::length(data.spaceBuffer) +
                         object::length(data.stores) +
                         object::length(data.supplements) +
-                        object::length(data.indexMap) +
+                        object::length(data.schedule) +
                         object::length(data.toggles);
                 }
 
@@ -1530,12 +1989,10 @@ namespace object
                 {
                     size_t count = 0;
 
-                    count += object::serialize(value.idCount, stream, index + count);       // STATIC
-                    count += object::serialize(value.functionIndex, stream, index + count); // STATIC
-                    count += object::serialize(value.spaceBuffer, stream, index + count);   // STATIC
+                    count += object::serialize(value.functionIndex, stream, index + count);
                     count += object::serialize(value.stores, stream, index + count);
                     count += object::serialize(value.supplements, stream, index + count);
-                    count += object::serialize(value.indexMap, stream, index + count);
+                    count += object::serialize(value.schedule, stream, index + count);
                     count += object::serialize(value.toggles, stream, index + count);
 
                     return count;
@@ -1546,17 +2003,8 @@ namespace object
                     SystemManager result = SystemManager();
                     size_t count = 0;
 
-                    // STATIC: special consideration may be required
-                    result.idCount = object::deserialize<uint32_t>(stream, index + count);
-                    count += object::length(result.idCount);
-
-                    // STATIC: special consideration may be required
                     result.functionIndex = object::deserialize<uint8_t>(stream, index + count);
                     count += object::length(result.functionIndex);
-                    
-                    // STATIC: special consideration may be required
-                    result.spaceBuffer = object::deserialize<std::vector<size_t>>(stream, index + count);
-                    count += object::length(result.spaceBuffer);
 
                     result.stores = object::deserialize<std::vector<system>>(stream, index + count);
                     count += object::length(result.stores);
@@ -1564,28 +2012,77 @@ namespace object
                     result.supplements = object::deserialize<std::vector<SystemSupplement>>(stream, index + count);
                     count += object::length(result.supplements);
 
-                    result.indexMap = object::deserialize<std::vector<uint32_t>>(stream, index + count);
-                    count += object::length(result.indexMap);
+                    result.schedule = object::deserialize<std::vector<uint32_t>>(stream, index + count);
+                    count += object::length(result.schedule);
 
                     result.toggles = object::deserialize<std::vector<SystemToggle>>(stream, index + count);
                     count += object::length(result.toggles);
 
+                    result.bind();
                     return result;
                 }
 
 
                 SystemManager() {}
 
-                SystemManager(entity numberOfEntities) : stores(idCount, system(functionIndex)), supplements(idCount, SystemSupplement(numberOfEntities)), indexMap(idCount, -1) {}
+                SystemManager(entity numberOfEntities)
+                {
+                    update(numberOfEntities);
+                }
+
+                // each `System` points back at `dispatchChanged`, so copies and moves must re-point them at the new owner
+                SystemManager(const SystemManager& other)
+                {
+                    *this = other;
+                }
+
+                SystemManager(SystemManager&& other)
+                {
+                    *this = std::move(other);
+                }
+
+                SystemManager& operator=(const SystemManager& other)
+                {
+                    functionIndex = other.functionIndex;
+                    stores = other.stores;
+                    supplements = other.supplements;
+                    schedule = other.schedule;
+                    toggles = other.toggles;
+                    dispatch = other.dispatch;
+                    dispatchChanged = other.dispatchChanged;
+                    bind();
+                    return *this;
+                }
+
+                SystemManager& operator=(SystemManager&& other)
+                {
+                    functionIndex = other.functionIndex;
+                    stores = std::move(other.stores);
+                    supplements = std::move(other.supplements);
+                    schedule = std::move(other.schedule);
+                    toggles = std::move(other.toggles);
+                    dispatch = std::move(other.dispatch);
+                    dispatchChanged = other.dispatchChanged;
+                    bind();
+                    return *this;
+                }
 
+                /**
+                 * @brief Runs a function on every `System` that has it set and active, in priority order.
+                 * 
+                 * @details The dispatch lists are rebuilt first if any `System` changed since the last run. Changes made
+                 *          while the function is running take effect on the next run.
+                 */
                 void runFunction(ecs& container, uint8_t index, void *data)
                 {
-                    for(size_t i=0; i<stores.size(); i++)
-                    {                  
-                        if(indexMap[i] != (entity)-1 && stores[indexMap[i]].isInitialized())
-                        {
-                            stores[indexMap[i]].runFunction(container, index, data);
-                        }
+                    if(dispatchChanged)
+                    {
+                        compile();
+                    }
+
+                    for(size_t i=0; i<dispatch[index].size(); i++)
+                    {
+                        stores[dispatch[index][i]].runFunction(container, index, data);
                     }
                 }
 
@@ -1749,62 +2246,50 @@ namespace object
                     {
                         store.createFunction();
                     }
+                    dispatchChanged = true;
                     return functionIndex++;
                 }
 
                 void update(entity numberOfEntities)
                 {
-                    while(supplements.size() < idCount)
+                    size_t size = stores.size();
+                    uint32_t count = systemRegistry().count();
+                    while(supplements.size() < count)
                     {
                         stores.push_back(system(functionIndex));
                         supplements.push_back(SystemSupplement(numberOfEntities));
-                        indexMap.push_back(-1);
+                    }
+
+                    if(size != stores.size())
+                    {
+                        bind();
                     }
                 }
 
+                /**
+                 * @brief Initializes a `System` and places it in the schedule.
+                 * 
+                 * @details `System`s run in ascending priority; a `System` is placed after every `System` that 
+                 *          shares its priority. Recreating a `System` moves it to its new position.
+                 */
                 template<typename T>
                 system& createSystem(const T& instance, int32_t priority, uint32_t id)
                 {
-                    uint32_t max = idCount-1;
-                    uint32_t index = max/2;
-                    uint32_t total = index, buffer;
-                    while (index != 0)
+                    if(stores[id].isInitialized())
                     {
-                        buffer = index;
-                        index = index/2;
-
-                        int32_t priorityTwo = (indexMap[total] == (entity)-1) ? INT_MAX : stores[indexMap[total]].priority;
-                        if(priorityTwo > priority)
-                        {
-                            total -= (index+(buffer % 2));
-                        }
-                        else
-                        {
-                            total += (index+(buffer % 2));
-                        }
-                    }
-
-                    
-                    if(id >= total)
-                    {
-                        for(uint32_t i=max; i>total; i--)
-                        {
-                            indexMap[i] = indexMap[i-1];
-                        }
-                    }
-                    else
-                    {
-                        for(uint32_t i=0; i<total; i++)
-                        {
-                            indexMap[i] = indexMap[i+1];
-                        }
+                        schedule.erase(std::find(schedule.begin(), schedule.end(), id));
                     }
 
-                    indexMap[total] = id;
-
                     stores[id].initialize<T>(instance);
                     stores[id].priority = priority;
 
+                    auto position = std::upper_bound(schedule.begin(), schedule.end(), priority, [this](int32_t value, uint32_t other)
+                    {
+                        return value < stores[other].priority;
+                    });
+                    schedule.insert(position, id);
+                    dispatchChanged = true;
+
                     return stores[id];
                 }
 
@@ -1846,14 +2331,42 @@ namespace object
                 template<typename T>
                 static uint32_t newId()
                 {
-                    uint32_t index = idCount;
-                    // whenever the compiler finds a new ComponentType, this function is called
-                    spaceBuffer.push_back(sizeof(T));
-                    idCount++;
-                    return index;
+                    // whenever the compiler finds a new SystemType, this function is called
+                    return systemRegistry().add(sizeof(T), std::is_trivially_copyable<T>(), object::typeName<T>());
                 }
 
                 private:
+                    void bind()
+                    {
+                        for(system& store : stores)
+                        {
+                            store.schedule = &dispatchChanged;
+                        }
+                    }
+
+                    // rebuilds the list of `System`s to run for each function
+                    void compile()
+                    {
+                        dispatch.resize(functionIndex);
+                        for(std::vector<uint32_t>& systems : dispatch)
+                        {
+                            systems.clear();
+                        }
+
+                        for(uint32_t id : schedule)
+                        {
+                            std::vector<SystemFunction>& functions = stores[id].functions;
+                            for(uint8_t i=0; i<functionIndex; i++)
+                            {
+                                if(functions[i].set && functions[i].active)
+                                {
+                                    dispatch[i].push_back(id);
+                                }
+                            }
+                        }
+                        dispatchChanged = false;
+                    }
+
                     template<typename Sys, typename S>
                     void addRequirement(uint32_t id)
                     {
@@ -1898,7 +2411,7 @@ namespace object
             ComponentManager componentManager;
             SystemManager systemManager;
 
-            static inline uint16_t error = 0;
+            uint16_t error = 0;
 
             void addComponentConfiguration(entity e, uint32_t id)
             {
@@ -1916,12 +2429,12 @@ namespace object
     };      
 
     template<typename T, typename>
-    T& ecs::ComponentArray::addComponent(size_t& index, const T& component)
+    T& ecs::ComponentArray::addComponent(size_t& index, const T& component, uint16_t& error)
     {
         #ifndef ECS_DEBUG_OFF
             if(index != (size_t)-1)
             {
-                ecs::error = 1;
+                error = 1;
                 return object::deserialize<T>(components, index);
             }
         #endif
@@ -1935,18 +2448,19 @@ namespace object
 
         // save the index for the entity
         index = arraySize;
+        count++;
 
         // could use `getComponent<T>()`, this avoids unnecessary index check
         return object::deserialize<T>(components, arraySize);
     }
 
     template<typename T, typename>
-    T ecs::ComponentArray::addComponent(size_t& index, const T& component)
+    T ecs::ComponentArray::addComponent(size_t& index, const T& component, uint16_t& error)
     {
         #ifndef ECS_DEBUG_OFF
             if(index != (size_t)-1)
             {
-                ecs::error = 1;
+                error = 1;
                 return T();
             }
         #endif
@@ -1961,6 +2475,7 @@ namespace object
 
         // save the index for the entity
         index = arraySize;
+        count++;
 
         // could use `getComponent<T>()`, this avoids unnecessary index check
         return object::deserialize<T>(components, index);
@@ -1968,13 +2483,13 @@ namespace object
 
 
     template<typename T, typename>
-    T& ecs::ComponentArray::getComponent(size_t index)
+    T& ecs::ComponentArray::getComponent(size_t index, uint16_t& error)
     {
         // indices set to `-1` represent uninitialized components; this triggers an error
         #ifndef ECS_DEBUG_OFF
             if(index == (size_t)-1)
             {
-                ecs::error = 2;
+                error = 2;
                 
                 // an empty component is stored at the start of each array; this is returned when an error occurs
                 return getDefaultComponent<T>();
@@ -1984,12 +2499,12 @@ namespace object
     }
 
     template<typename T, typename>
-    T ecs::ComponentArray::getComponent(size_t index)
+    T ecs::ComponentArray::getComponent(size_t index, uint16_t& error)
     {
         #ifndef ECS_DEBUG_OFF
             if(index == (size_t)-1)
             {
-                ecs::error = 2;
+                error = 2;
                 T();
             }
         #endif
@@ -1998,13 +2513,13 @@ namespace object
 
 
     template<typename T>
-    size_t ecs::ComponentArray::setComponent(size_t index, const T& update)
+    size_t ecs::ComponentArray::setComponent(size_t index, const T& update, uint16_t& error)
     {
         // indices set to `-1` represent uninitialized components; this triggers an error
         #ifndef ECS_DEBUG_OFF
             if(index == (size_t)-1)
             {
-                ecs::error = 2;
+                error = 2;
                 return 0;
             }
         #endif
@@ -14,56 +14,7 @@ struct CharacterTTF
     std::vector<uint16_t> contourEnds;
     std::vector<Point> points;
 
-    static size_t length(const CharacterTTF& data)
-    {        
-        return 
-            object::length(data.min) + 
-            object::length(data.scale) +
-            object::length(data.lsb) +
-            object::length(data.rsb) +
-            object::length(data.contourEnds) +
-            object::length(data.points);
-    }
-
-    static size_t serialize(const CharacterTTF& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.min, stream, index + count);
-        count += object::serialize(value.scale, stream, index + count);
-        count += object::serialize(value.lsb, stream, index + count);
-        count += object::serialize(value.rsb, stream, index + count);
-        count += object::serialize(value.contourEnds, stream, index + count);
-        count += object::serialize(value.points, stream, index + count);
-
-        return count;
-    }
-
-    static CharacterTTF deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        CharacterTTF result = CharacterTTF();
-        size_t count = 0;
-
-        result.min = object::deserialize<Vector2I>(stream, index + count);
-        count += object::length(result.min);
-
-        result.scale = object::deserialize<Vector2I>(stream, index + count);
-        count += object::length(result.scale);
-
-        result.lsb = object::deserialize<int32_t>(stream, index + count);
-        count += object::length(result.lsb);
-
-        result.rsb = object::deserialize<int32_t>(stream, index + count);
-        count += object::length(result.rsb);
-
-        result.contourEnds = object::deserialize<std::vector<uint16_t>>(stream, index + count);
-        count += object::length(result.contourEnds);
-
-        result.points = object::deserialize<std::vector<Point>>(stream, index + count);
-        count += object::length(result.points);
-
-        return result;
-    }
+    VENUS_FIELDS(CharacterTTF, min, scale, lsb, rsb, contourEnds, points)
 };
 
 //
@@ -73,41 +24,7 @@ struct Font
     std::vector<CharacterTTF> characters;
     uint16_t unitsPerEm;
 
-    static size_t length(const Font& data)
-    {        
-        return 
-            object::length(data.maxScale) + 
-            object::length(data.characters) +
-            object::length(data.unitsPerEm);
-    }
-
-    static size_t serialize(const Font& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.maxScale, stream, index + count);
-        count += object::serialize(value.characters, stream, index + count);
-        count += object::serialize(value.unitsPerEm, stream, index + count);
-
-        return count;
-    }
-
-    static Font deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        Font result = Font();
-        size_t count = 0;
-
-        result.maxScale = object::deserialize<Vector2>(stream, index + count);
-        count += object::length(result.maxScale);
-
-        result.characters = object::deserialize<std::vector<CharacterTTF>>(stream, index + count);
-        count += object::length(result.characters);
-
-        result.unitsPerEm = object::deserialize<uint16_t>(stream, index + count);
-        count += object::length(result.unitsPerEm);
-
-        return result;
-    }
+    VENUS_FIELDS(Font, maxScale, characters, unitsPerEm)
 
     static void loadAll(const std::string &directory);
     static void load(const std::string &fileName, const std::string &path);
@@ -146,55 +63,47 @@ struct Sprite
 {
     Texture texture;
 
-    static size_t length(const Sprite& data)
-    {        
-        return 
-            object::length(data.texture) + 
-            object::length(data.square);
-    }
-
-    static size_t serialize(const Sprite& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.texture, stream, index + count);
-        count += object::serialize(value.square, stream, index + count);
-
-        return count;
-    }
-
-    static Sprite deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        Sprite result = Sprite();
-        size_t count = 0;
-
-        result.texture = object::deserialize<Texture>(stream, index + count);
-        count += object::length(result.texture);
-
-        result.square = object::deserialize<Mesh>(stream, index + count);
-        count += object::length(result.square);
-
-        return result;
-    }
-
     Sprite(){}
     Sprite(const Texture& texture__) : texture(texture__)
     {
-        square = Mesh::get("square");
+        square = Mesh::handle("square");
     }
     
     void refresh()
     {
-        square.refresh();
+        Mesh::get(square).refresh();
     }
-    void render()
+    void render() const
     {
-        square.draw(texture.texture);
+        Mesh::get(square).draw(texture.texture);
     }
 
     private:
-        Mesh square;
+        MeshHandle square;
         float sorting = 0;
+
+        friend struct object::Persistence<Sprite>;
+};
+VENUS_NAME(Sprite)
+
+// as with Model, the mesh handle is an index into this process's registry, so a serialized Sprite stores the mesh's path instead
+template<>
+struct object::Persistence<Sprite>
+{
+    static void write(const Sprite& sprite, std::vector<uint8_t>& stream)
+    {
+        std::string path = Mesh::path(sprite.square);
+        size_t index = stream.size();
+        stream.resize(index + object::length(path));
+        object::serialize(path, stream, index);
+    }
+
+    static size_t read(Sprite& sprite, std::vector<uint8_t>& stream, size_t index)
+    {
+        std::string path = object::deserialize<std::string>(stream, index);
+        sprite.square = path.empty() ? MeshHandle() : Mesh::handle(path);
+        return object::length(path);
+    }
 };
 
 
@@ -252,66 +161,12 @@ struct Rect
             return Vector2(alignment.horizontal-1, alignment.vertical-1);
         }
 };
+VENUS_NAME(Rect)
 
 //
 struct Text
 {        
-    static size_t length(const Text& data)
-    {        
-        return 
-            object::length(data.font) + 
-            object::length(data.text) +
-            object::length(data.scale) +
-            object::length(data.spacing) +
-            object::length(data.linePadding) +
-            object::length(data.newLineSetting) +
-            object::length(data.alignment);
-    }
-
-    static size_t serialize(const Text& value, std::vector<uint8_t>& stream, size_t index)
-    {
-        size_t count = 0;
-
-        count += object::serialize(value.font, stream, index + count);
-        count += object::serialize(value.text, stream, index + count);
-        count += object::serialize(value.scale, stream, index + count);
-        count += object::serialize(value.spacing, stream, index + count);
-        count += object::serialize(value.linePadding, stream, index + count);
-        count += object::serialize(value.newLineSetting, stream, index + count);
-        count += object::serialize(value.alignment, stream, index + count);
-
-        return count;
-    }
-
-    static Text deserialize(std::vector<uint8_t>& stream, size_t index)
-    {
-        Text result = Text();
-        size_t count = 0;
-
-        result.font = object::deserialize<Font>(stream, index + count);
-        count += object::length(result.font);
-
-        result.text = object::deserialize<std::string>(stream, index + count);
-        count += object::length(result.text);
-
-        result.scale = object::deserialize<float>(stream, index + count);
-        count += object::length(result.scale);
-
-        result.spacing = object::deserialize<float>(stream, index + count);
-        count += object::length(result.spacing);
-
-        result.linePadding = object::deserialize<float>(stream, index + count);
-        count += object::length(result.linePadding);
-
-        result.newLineSetting = object::deserialize<text::NewLineSetting>(stream, index + count);
-        count += object::length(result.newLineSetting);
-
-        result.alignment = object::deserialize<Alignment>(stream, index + count);
-        count += object::length(result.alignment);
-
-        return result;
-    }
-
+    VENUS_FIELDS(Text, font, text, scale, spacing, linePadding, newLineSetting, alignment)
 
     Text() {}
     Text(const Font& font__, const std::string& text__, float scale__, const Alignment& alignment__);    
@@ -324,6 +179,7 @@ struct Text
         text::NewLineSetting newLineSetting = text::WORD;
         Alignment alignment;
 };
+VENUS_NAME(Text)
 
 
 //
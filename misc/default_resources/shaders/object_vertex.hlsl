@@ -4,17 +4,38 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 
+// per-instance attributes :: model matrix rows, color, scale and flip, uv offset and scale, material strengths
+layout (location = 3) in vec4 aModel0;
+layout (location = 4) in vec4 aModel1;
+layout (location = 5) in vec4 aModel2;
+layout (location = 6) in vec4 aModel3;
+layout (location = 7) in vec4 aColor;
+layout (location = 8) in vec4 aScale;
+layout (location = 9) in vec4 aUV;
+layout (location = 10) in vec4 aMaterial;
+
 out vec2 TexCoord;
 out vec3 FragPos;
 out vec3 Normal;
+flat out vec4 Color;
+flat out vec4 Surface;
+flat out float Flip;
 
-uniform mat4 model, view, projection;
-uniform vec3 scale;
+layout (std140, row_major) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos * scale, 1.0f));
+    mat4 model = transpose(mat4(aModel0, aModel1, aModel2, aModel3));
+    FragPos = vec3(model * vec4(aPos * aScale.xyz, 1.0f));
     gl_Position = projection * view * vec4(FragPos, 1.0);
-    TexCoord = aTexCoord;
+    TexCoord = aUV.zw * aTexCoord + aUV.xy;
     Normal = normalize(transpose(inverse(mat3(model))) * aNormal);
+    Color = aColor;
+    Surface = aMaterial;
+    Flip = aScale.w;
 }
\ No newline at end of file
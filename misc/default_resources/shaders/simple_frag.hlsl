@@ -11,10 +11,10 @@ out vec4 FragColor;
 in vec2 TexCoord;
 
 uniform Material material;
-uniform vec4 objColor;
-uniform bool flip;
+flat in vec4 Color;
+flat in float Flip;
 
 void main()
 { 
-    FragColor = texture(material.texture, vec2((float(flip) * -2 + 1) * TexCoord.x, TexCoord.y)) * objColor;
+    FragColor = texture(material.texture, vec2((Flip * -2 + 1) * TexCoord.x, TexCoord.y)) * Color;
 }
\ No newline at end of file
@@ -138,20 +138,21 @@ void project::initialize(Application& app)
     };
     auto& event = container.createSystem<Event>();
     {
-        event.setFunction(object::fn::LOAD, []
+        // only looks assets up, so it can build the world on the loader's worker
+        event.setFunction(object::fn::BUILD, []
         (object::ecs& container, object::ecs::system& script, void *data)
         {
             Event& event = script.getInstance<Event>();
 
             entity sphere = container.createEntity();
             container.addComponent<Transform>(sphere, Transform(Vector3(0, -0.5f, 0), 2));
-            container.addComponent<Model>(sphere, Model(Texture::get("default"), Mesh::get("sphere")));
+            container.addComponent<Model>(sphere, Model(Texture::get("default"), Mesh::handle("sphere")));
             container.addComponent<AdvancedShader>(sphere, {color::SOFTPEACH, 0.15f, 0.6f, 0.25f, 256});
             container.addComponent<Audio>(sphere, Audio(Audio::get("breeze.wav")));
 
             event.floor = container.createEntity();
             container.addComponent<Transform>(event.floor, Transform(Vector3(0, -2, -30), 20, Quaternion(math::radians(90), vec3::left)));
-            container.addComponent<Model>(event.floor, Model(Texture::get("crate.png"), Mesh::get("square")));
+            container.addComponent<Model>(event.floor, Model(Texture::get("crate.png"), Mesh::handle("square")));
             container.addComponent<AdvancedShader>(event.floor, {color::WHITE, 0.2f, 0.5f, 0.1f, 64});
             container.addComponent<MeshAddon>(event.floor, // MeshAddon attaches copies of the original mesh with different Transforms so that they are rendered in the same draw call. If this component is added to an object, changes to this object's Transform will likely cause unwanted behavior.
             MeshAddon
@@ -162,14 +163,14 @@ void project::initialize(Application& app)
             entity spotlight = container.createEntity();
             event.spot = spotlight;
             container.addComponent<Transform>(spotlight, {Vector3(0, 2, 0), 0.25f});
-            container.addComponent<Model>(spotlight, Model(Texture::get("default"), Mesh::get("cube")));
+            container.addComponent<Model>(spotlight, Model(Texture::get("default"), Mesh::handle("cube")));
             container.addComponent<SimpleShader>(spotlight, color::WHITE);
             container.addComponent<SpotLight>(spotlight, SpotLight(vec3::down, color::WHITE, 1.0f, object::brightness(5), std::cos(math::radians(30.0f)), std::cos(math::radians(20.0f))));
 
             entity pointlight = container.createEntity();
             event.point = pointlight;
             container.addComponent<Transform>(pointlight, {Vector3(0, -0.1f, 2), 0.1f});
-            container.addComponent<Model>(pointlight, Model(Texture::get("default"), Mesh::get("sphere")));
+            container.addComponent<Model>(pointlight, Model(Texture::get("default"), Mesh::handle("sphere")));
             container.addComponent<SimpleShader>(pointlight, color::PRIMROSEPETAL);
             container.addComponent<PointLight>(pointlight, PointLight(color::PRIMROSEPETAL, 1.0f, object::brightness(3)));
         });
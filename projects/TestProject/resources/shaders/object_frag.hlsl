@@ -1,117 +1,162 @@
 #version 330 core
 
-#define MAX_POINT 32
-#define MAX_SPOT 32
+// must match LightClusters::X, Y and Z
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
 
 struct Material
 {
     sampler2D diffuse;
     sampler2D specular;
-
-    float shininess;
-    float ambientStrength;
-    float diffuseStrength;
-    float specularStrength;
 };
 uniform Material material;
 
+// the directional light and the cluster basis are read from the 'Lights' block, which follows the std140 layout of LightBlock
 struct DirLight
 {
     vec3 direction;
-    vec4 color;
-
     float strength;
+    vec4 color;
 };
-uniform DirLight dirLight;
 
-struct PointLight
+layout (std140) uniform Lights
 {
-    vec3 position;
-    vec4 color;
-
-    float strength;
-    float constant;
-    float linear;
-    float quadratic;
+    DirLight dirLight;
+    vec3 clusterFront;
+    float clusterNear;
+    vec3 clusterRight;
+    float clusterTanX;
+    vec3 clusterUp;
+    float clusterTanY;
+    float clusterScale;
 };
-uniform PointLight pointLights[MAX_POINT+1];
-uniform int totalPointLights;
 
-struct SpotLight
+// point and spot lights live in 'lightData' as four texels each (see LightClusters::Light); 'lightGrid' holds each cluster's offset and count into 'lightIndices'
+uniform samplerBuffer lightData;
+uniform usamplerBuffer lightGrid;
+uniform usamplerBuffer lightIndices;
+
+struct Light
 {
     vec3 position;
-    vec3 direction;
+    float strength;
     vec4 color;
 
-    float strength;
     float constant;
     float linear;
     float quadratic;
-    float cutOff, outerCutOff;
+    float outerCutOff;
+
+    vec3 direction;
+    float cutOff;
 };
-uniform SpotLight spotLights[MAX_SPOT+1];
-uniform int totalSpotLights;
 
-uniform vec3 viewPos;
-uniform vec4 objColor;
+layout (std140, row_major) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
 
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoord;
+flat in vec4 Color;
+flat in vec4 Surface;  // ambient, diffuse, specular, shininess
 
 out vec4 FragColor;
 
 vec4 calcDirLight(vec4 color, vec3 normal, vec3 viewDir);
-vec4 calcPointLight(PointLight light, vec4 color, vec3 normal, vec3 viewDir);
-vec4 calcSpotLight(SpotLight light, vec4 color, vec3 normal, vec3 viewDir);
+vec4 calcPointLight(Light light, vec4 color, vec3 normal, vec3 viewDir);
+vec4 calcSpotLight(Light light, vec4 color, vec3 normal, vec3 viewDir);
+int findCluster();
+Light fetchLight(int index);
 
 void main()
 { 
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec4 color =  texture(material.diffuse, TexCoord) * objColor;
+    vec4 color =  texture(material.diffuse, TexCoord) * Color;
 
-    vec4 result = vec4(0, 0, 0, objColor.a);
+    vec4 result = vec4(0, 0, 0, Color.a);
     result += calcDirLight(color, norm, viewDir);
-    for(int i = 0; i < totalPointLights; i++)
-        result += calcPointLight(pointLights[i], color, norm, viewDir);
-    for(int i = 0; i < totalSpotLights; i++)
-        result += calcSpotLight(spotLights[i], color, norm, viewDir);
+
+    uvec2 cluster = texelFetch(lightGrid, findCluster()).xy;
+    for(uint i = 0u; i < cluster.y; i++)
+    {
+        Light light = fetchLight(int(texelFetch(lightIndices, int(cluster.x + i)).r));
+        if(light.cutOff < -1.0)
+            result += calcPointLight(light, color, norm, viewDir);
+        else
+            result += calcSpotLight(light, color, norm, viewDir);
+    }
     FragColor = result;
 }
 
+// mirrors the froxel layout of LightClusters::build :: fragments outside the grid are clamped into its outer clusters
+int findCluster()
+{
+    vec3 relative = FragPos - viewPos;
+    float depth = max(dot(relative, clusterFront), clusterNear);
+
+    int x = clamp(int((dot(relative, clusterRight) / (depth * clusterTanX) * 0.5 + 0.5) * CLUSTER_X), 0, CLUSTER_X - 1);
+    int y = clamp(int((dot(relative, clusterUp) / (depth * clusterTanY) * 0.5 + 0.5) * CLUSTER_Y), 0, CLUSTER_Y - 1);
+    int z = clamp(int(log(depth / clusterNear) * clusterScale), 0, CLUSTER_Z - 1);
+    return (z * CLUSTER_Y + y) * CLUSTER_X + x;
+}
+
+Light fetchLight(int index)
+{
+    vec4 positionStrength = texelFetch(lightData, index * 4);
+    vec4 attenuation = texelFetch(lightData, index * 4 + 2);
+    vec4 directionCutOff = texelFetch(lightData, index * 4 + 3);
+
+    Light light;
+    light.position = positionStrength.xyz;
+    light.strength = positionStrength.w;
+    light.color = texelFetch(lightData, index * 4 + 1);
+    light.constant = attenuation.x;
+    light.linear = attenuation.y;
+    light.quadratic = attenuation.z;
+    light.outerCutOff = attenuation.w;
+    light.direction = directionCutOff.xyz;
+    light.cutOff = directionCutOff.w;
+    return light;
+}
+
 vec4 calcDirLight(vec4 color, vec3 normal, vec3 viewDir)
 {
-    vec4 finalColor = color * max(0, dot(dirLight.direction, -normal)) * material.diffuseStrength;
-    finalColor += color * pow(max(0, dot(normalize(viewDir + dirLight.direction), -normal)), material.shininess) * material.specularStrength;
+    vec4 finalColor = color * max(0, dot(dirLight.direction, -normal)) * Surface.y;
+    finalColor += color * pow(max(0, dot(normalize(viewDir + dirLight.direction), -normal)), Surface.w) * Surface.z;
     
-    return (finalColor * dirLight.color + color * material.ambientStrength) * dirLight.strength;
+    return (finalColor * dirLight.color + color * Surface.x) * dirLight.strength;
 }
 
-vec4 calcPointLight(PointLight light, vec4 color, vec3 normal, vec3 viewDir)
+vec4 calcPointLight(Light light, vec4 color, vec3 normal, vec3 viewDir)
 {
     vec3 lightDir = normalize(light.position - FragPos);
     vec3 halfwayDir = normalize(lightDir + viewDir);
 
     float diff = max(dot(normal, lightDir), 0.0);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), Surface.w);
 
     float distance = length(light.position - FragPos);
     float attenuation = 1.0f / (light.constant + light.linear*distance + light.quadratic*(distance*distance));
 
-    vec3 diffuse = material.diffuseStrength * diff * attenuation * vec3(color) * vec3(light.color);
-    vec3 specular = material.specularStrength * spec * attenuation * vec3(color) * vec3(light.color);
+    vec3 diffuse = Surface.y * diff * attenuation * vec3(color) * vec3(light.color);
+    vec3 specular = Surface.z * spec * attenuation * vec3(color) * vec3(light.color);
 
     return vec4((diffuse + specular) * light.strength, color.a);
 }
 
-vec4 calcSpotLight(SpotLight light, vec4 color, vec3 normal, vec3 viewDir)
+vec4 calcSpotLight(Light light, vec4 color, vec3 normal, vec3 viewDir)
 {
     vec3 lightDir = normalize(light.position - FragPos);
     vec3 reflectDir = reflect(-lightDir, normal);
     
     float diff = max(dot(normal, lightDir), 0.0);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), Surface.w);
     
     float distance = length(light.position - FragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -120,8 +165,8 @@ vec4 calcSpotLight(SpotLight light, vec4 color, vec3 normal, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     
-    vec3 diffuse = material.diffuseStrength * diff * attenuation * intensity * vec3(color) * vec3(light.color);
-    vec3 specular = material.specularStrength * spec * attenuation * intensity * vec3(color) * vec3(light.color);
+    vec3 diffuse = Surface.y * diff * attenuation * intensity * vec3(color) * vec3(light.color);
+    vec3 specular = Surface.z * spec * attenuation * intensity * vec3(color) * vec3(light.color);
 
     return vec4((diffuse + specular) * light.strength, color.a);
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "image/stb_image.h"
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <limits>
 #include <type_traits>
@@ -120,7 +122,7 @@ Vector3 object::brightness(int32_t value)
 
 namespace object::fn
 {
-    uint8_t LOAD, START, UPDATE, LATE_UPDATE, FIXED_UPDATE, RENDER, DESTROY;
+    uint8_t PREPARE, BUILD, LOAD, START, UPDATE, LATE_UPDATE, FIXED_UPDATE, RENDER, DESTROY;
 }
 
 void object::defaultInsertion(entity e, std::vector<entity>& entities, std::vector<size_t>& map)
@@ -163,7 +165,8 @@ void object::setFunctionDefinitions(object::ecs& container, const std::vector<ui
 
 void MeshAddon::append(Model& model, const Transform& parentTransform)
 {
-    std::vector<Vertex> newVertices = model.data.getVertices();
+    const Mesh& source = model.mesh();
+    Mesh mesh = source;
     Vector3 average = 0, max = 0, min = -std::numeric_limits<float>::lowest();
     for(int i=0; i<additions.size(); i++)
     {
@@ -179,20 +182,17 @@ void MeshAddon::append(Model& model, const Transform& parentTransform)
         min = vec3::min(min, additions[i].transform.position);
         
         additions[i].transform.position = (mat4x4)parentTransform.rotation * additions[i].transform.position;
-        model.data.append(newVertices, additions[i].transform.position, additions[i].transform.rotation, parentTransform.rotation, additions[i].uvScale, additions[i].uvOffset);
+        mesh.append(source, additions[i].transform.position, additions[i].transform.rotation, parentTransform.rotation, additions[i].uvScale, additions[i].uvOffset);
     }
 
-    model.data.offset += average;
-    model.data.dimensions += (max-min) * model.data.dimensions;
+    mesh.offset += average;
+    mesh.dimensions += (max-min) * mesh.dimensions;
 
-    std::string addendumPath = model.data.identifier();
-    if(!Mesh::contains(addendumPath))
-    {
-        model.data.generate();
-        addendumPath = model.data.identifier();
-    }
-    Mesh::set(addendumPath, model.data);
-    model.data.refresh();
+    // shared meshes are registered by name, so a combined mesh gets its own buffers and leaves the original untouched
+    if(!Mesh::contains(mesh.identifier()))
+        mesh.generate();
+    model.data = Mesh::set(mesh.identifier(), mesh);
+    model.refresh();
 }
 
 // cannot interpret MUTE, DECR_VOLUME, INCR_VOLUME, CALCULATOR, GLOBAL_2, GLOBAL_3, and GLOBAL_4
@@ -283,6 +283,12 @@ void Screen::initialize(const DirectionalLight& dirLight__, const Shader& screen
     screenShader.use();
     screenShader.setInt("screenTexture", 0);
 
+    cameraBuffer.initialize(CameraBlock::BINDING, sizeof(CameraBlock));
+    cameraBuffer.update(&cameraBlock, sizeof(CameraBlock));
+    lightBuffer.initialize(LightBlock::BINDING, sizeof(LightBlock));
+    lightBuffer.update(&lights, sizeof(LightBlock));
+    clusters.initialize();
+
     int complete;
     if((complete = frameBuffer.complete()) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "ERROR :: " << complete << " :: Screen subbuffer is not complete." << std::endl;
@@ -292,11 +298,46 @@ void Screen::initialize(const DirectionalLight& dirLight__, const Shader& screen
 }
 void Screen::remove()
 {
+    queue.remove();
+    cameraBuffer.remove();
+    lightBuffer.remove();
+    clusters.remove();
     frameBuffer.remove();
     subBuffer.remove();
     depthBuffer.remove();
     screenShader.remove();
 }
+// each block is written with a single glBufferSubData, and only when its contents changed since the last upload :: the light clusters follow the camera, so they are rebuilt whenever it or any light moves
+void Screen::updateBlocks(const Camera& cam, const Vector3& position, float aspect)
+{
+    CameraBlock block;
+    block.view = cam.view;
+    block.projection = cam.projection;
+    block.position = position;
+    bool cameraChanged = std::memcmp(&block, &cameraBlock, sizeof(CameraBlock));
+    if(cameraChanged)
+    {
+        cameraBlock = block;
+        cameraBuffer.update(&cameraBlock, sizeof(CameraBlock));
+    }
+
+    LightBlock updated = lights;
+    updated.directional.direction = dirLight.direction;
+    updated.directional.strength = dirLight.strength;
+    updated.directional.color = dirLight.color;
+    if(cameraChanged || clusters.changed)
+    {
+        clusters.build(updated, position, cam.front, cam.up, cam.fov, aspect, cam.nearDistance, cam.farDistance);
+        clusters.changed = false;
+    }
+
+    if(std::memcmp(&updated, &lights, sizeof(LightBlock)))
+    {
+        lights = updated;
+        lightBuffer.update(&lights, sizeof(LightBlock));
+    }
+    clusters.bind(1);
+}
 void Screen::refreshResolution(const Vector2& res)
 {
     frameBuffer.refresh(res.x, res.y, defaultColor.a == 1);
@@ -307,7 +348,7 @@ void Screen::store()
 {
     glViewport(0, 0, resolution.x, resolution.y);
     frameBuffer.bind(GL_FRAMEBUFFER);
-    glEnable(GL_DEPTH_TEST);
+    glstate::depthTest(true);
 }
 void Screen::draw()
 {
@@ -316,7 +357,7 @@ void Screen::draw()
     glBlitFramebuffer(0, 0, resolution.x, resolution.y, 0, 0, resolution.x, resolution.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
     
     frameBuffer.unbind(GL_FRAMEBUFFER);
-    glDisable(GL_DEPTH_TEST);
+    glstate::depthTest(false);
     glClearColor(defaultColor.r, defaultColor.g, defaultColor.b, defaultColor.a);
     glClear(GL_COLOR_BUFFER_BIT);
     
@@ -1334,7 +1375,7 @@ void Window::configureGLAD()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
-    glEnable(GL_DEPTH_TEST);
+    glstate::depthTest(true);
     glEnable(GL_STENCIL_TEST);
     glEnable(GL_CULL_FACE);
     glEnable(GL_MULTISAMPLE);
@@ -1342,35 +1383,68 @@ void Window::configureGLAD()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 }
 
+// registers every animator of system 'S' with a shared batch in 'scene' and removes the animator component :: the system then only lists animators 
+// added since, and ClipManager plays the clip the batch chooses
+template<typename S, typename A>
+void registerAnimators(object::ecs& container, Scene& scene)
+{
+    // registering removes entities from this system's list, so it is copied first
+    std::vector<entity> entities = container.entities<S>();
+    for(entity e : entities)
+    {
+        A animator = container.getComponent<A>(e);
+        std::vector<std::vector<uint32_t>> offsets;
+        auto flat = object::flatten(animator, offsets);
+
+        // one clip per flattened state, in the order 'flatten' lays them out
+        std::vector<uint32_t> clips;
+        for(auto& state : animator.states)
+        {
+            if(state.states.empty())
+                clips.push_back(ClipAnimator::NONE);
+            for(auto& animation : state.states)
+            {
+                clips.push_back(AnimationClip::intern(AnimationClip::from(animation)));
+            }
+        }
+        scene.addMachine(e, object::MachineBatch(flat), clips, offsets);
+        container.removeComponent<A>(e);
+    }
+}
+
 void initializeECS(object::ecs& manager)
 {  
-    object::setFunctionDefinitions(manager, {&object::fn::LOAD, &object::fn::START, &object::fn::UPDATE, &object::fn::LATE_UPDATE, &object::fn::FIXED_UPDATE, &object::fn::RENDER, &object::fn::DESTROY});
+    object::setFunctionDefinitions(manager, {&object::fn::PREPARE, &object::fn::BUILD, &object::fn::LOAD, &object::fn::START, &object::fn::UPDATE, &object::fn::LATE_UPDATE, &object::fn::FIXED_UPDATE, &object::fn::RENDER, &object::fn::DESTROY});
     
     auto& pointlights = manager.createSystem<PointLightManager, PointLight, Transform>({}, 3);
     pointlights.setFunction(object::fn::UPDATE, []
     (object::ecs &container, object::ecs::system &system, void *data)
     {
         std::vector<entity>& entities = container.entities<PointLightManager>();
+        LightClusters& clusters = Application::data(data).window().screen.clusters;
+        std::vector<LightClusters::Light>& points = clusters.points;
 
-        Shader& shader = Shader::get("object_shader");
-        shader.use();
-        shader.setInt("totalPointLights", entities.size());
+        clusters.changed |= points.size() != entities.size();
+        points.resize(entities.size());
 
-        uint32_t iterator = 0;
-        for(entity e : entities)
+        for(size_t i=0; i<entities.size(); i++)
         {
-            Transform& transform = container.getComponent<Transform>(e);
-            PointLight& light = container.getComponent<PointLight>(e);
-
-            std::string name = "pointLights[" + std::to_string(iterator) + "]";
-            shader.setVec3(name + ".position", transform.position);
-            shader.setVec4(name + ".color", light.color);
-            shader.setFloat(name + ".strength", light.strength);
-            
-            shader.setFloat(name + ".constant", light.constant);
-            shader.setFloat(name + ".linear", light.linear);
-            shader.setFloat(name + ".quadratic", light.quadratic);
-            iterator++;
+            Transform& transform = container.getComponent<Transform>(entities[i]);
+            PointLight& light = container.getComponent<PointLight>(entities[i]);
+
+            LightClusters::Light point;
+            point.position = transform.position;
+            point.strength = light.strength;
+            point.color = light.color;
+            point.constant = light.constant;
+            point.linear = light.linear;
+            point.quadratic = light.quadratic;
+
+            if(std::memcmp(&point, &points[i], sizeof(point)))
+            {
+                points[i] = point;
+                clusters.changed = true;
+            }
         }
     });
 
@@ -1379,29 +1453,33 @@ void initializeECS(object::ecs& manager)
     (object::ecs & container, object::ecs::system &system, void *data)
     {
         const std::vector<entity>& entities = container.entities<SpotLightManager>();
-        Shader& shader = Shader::get("object_shader");
-        shader.use();
-        shader.setInt("totalSpotLights", entities.size());
+        LightClusters& clusters = Application::data(data).window().screen.clusters;
+        std::vector<LightClusters::Light>& spots = clusters.spots;
+
+        clusters.changed |= spots.size() != entities.size();
+        spots.resize(entities.size());
 
-        uint32_t iterator = 0;
-        for(entity e : entities)
+        for(size_t i=0; i<entities.size(); i++)
         {
-            Transform& transform = container.getComponent<Transform>(e);
-            SpotLight& light = container.getComponent<SpotLight>(e);
-
-            std::string name = "spotLights[" + std::to_string(iterator) + "]";
-            shader.setVec3(name + ".position", transform.position);
-            shader.setVec3(name + ".direction", light.direction);
-            shader.setVec4(name + ".color", light.color);
-            shader.setFloat(name + ".strength", light.strength);
-            
-            shader.setFloat(name + ".constant", light.constant);
-            shader.setFloat(name + ".linear", light.linear);
-            shader.setFloat(name + ".quadratic", light.quadratic);
-
-            shader.setFloat(name + ".cutOff", light.cutoff);
-            shader.setFloat(name + ".outerCutOff", light.outerCutOff);
-            iterator++;
+            Transform& transform = container.getComponent<Transform>(entities[i]);
+            SpotLight& light = container.getComponent<SpotLight>(entities[i]);
+
+            LightClusters::Light spot;
+            spot.position = transform.position;
+            spot.strength = light.strength;
+            spot.direction = light.direction;
+            spot.cutOff = light.cutoff;
+            spot.color = light.color;
+            spot.constant = light.constant;
+            spot.linear = light.linear;
+            spot.quadratic = light.quadratic;
+            spot.outerCutOff = light.outerCutOff;
+
+            if(std::memcmp(&spot, &spots[i], sizeof(spot)))
+            {
+                spots[i] = spot;
+                clusters.changed = true;
+            }
         }
     });
 
@@ -1583,56 +1661,74 @@ void initializeECS(object::ecs& manager)
     });
 
     auto& animations = manager.createSystem<AnimationManager, Animator2D, Model>({}, 24);
-    animations.setFunction(object::fn::FIXED_UPDATE, []
+    animations.setFunction(object::fn::START, []
     (object::ecs & container, object::ecs::system &system, void *data)
     {
-        for(entity e : container.entities<AnimationManager>())
-        {
-            Animator2D animator = container.getComponent<Animator2D>(e);
-            AnimationState state = animator.getCurrent();
-            Animation2D animation = state.getCurrent();
-            Model model = container.getComponent<Model>(e);
-            Texture current = animation.current();
-            if(current != Texture() && model.texture != current)
-            {
-                model.texture = current;
-                container.setComponent<Model>(e, model);
-            }
+        registerAnimators<AnimationManager, Animator2D>(container, Application::data(data).getScene());
+    });
 
-            animation.currentFrame = (animation.currentFrame + 1) % animation.frames.size();
-            state.setState(animation);
-            animator.setState(state);
-            container.setComponent<Animator2D>(e, animator);
+    auto& clips = manager.createSystem<ClipManager, ClipAnimator, Transform, Model>({}, 24);
+    // the batches live in the Scene, so they are advanced from here to be paused along with ClipManager's other functions
+    clips.setFunction(object::fn::FIXED_UPDATE, []
+    (object::ecs & container, object::ecs::system &system, void *data)
+    {
+        Application::data(data).getScene().updateMachines();
+    });
+    clips.setFunction(object::fn::UPDATE, []
+    (object::ecs & container, object::ecs::system &system, void *data)
+    {
+        float seconds = Application::data(data).getTime().deltaTime;
+        for(entity e : container.entities<ClipManager>())
+        {
+            ClipAnimator& animator = container.getComponent<ClipAnimator>(e);
+            animator.time += animator.speed * seconds;
         }
     });
-
-    auto& animationsUV = manager.createSystem<AnimationUVManager, AnimatorUV, Model>({}, 24);
-    animationsUV.setFunction(object::fn::FIXED_UPDATE, []
+    // runs before the renderers :: frames are only sampled for entities the camera can see
+    clips.setFunction(object::fn::RENDER, []
     (object::ecs & container, object::ecs::system &system, void *data)
     {
-        for(entity e : container.entities<AnimationUVManager>())
+        Window& win = Application::data(data).window();
+        uint32_t cam = win.screen.camera;
+        if(cam == -1)
+            return;
+
+        Camera& camera = container.getComponent<Camera>(cam);
+        Transform& cameraTransform = container.getComponent<Transform>(cam);
+        Frustum frustum = camera.getFrustum(cameraTransform.position, win.aspectRatioInv());
+
+        for(entity e : container.entities<ClipManager>())
         {
-            AnimatorUV animator = container.getComponent<AnimatorUV>(e);
-            AnimationStateUV state = animator.getCurrent();
-            AnimationUV animation = state.getCurrent();
-            Model model = container.getComponent<Model>(e);
-            Texture current = animation.texture;
-            
-            if(model.texture != current || (animation.update() && (animation.type != AnimationUV::STOP || animation.currentFrame != animation.length-1)))
-            {
-                model.texture = current;
-                model.scale = Vector2(1.0f / animation.bounds.x, 1.0f / animation.bounds.y);
-                model.offset = Vector2((animation.currentFrame % animation.bounds.x) / (float)animation.bounds.x, (animation.bounds.y - (int)(animation.currentFrame / animation.bounds.x) - 1) / (float)animation.bounds.y);
-                container.setComponent<Model>(e, model);
-                animation.currentFrame = (animation.currentFrame + 1) % animation.length;
-            }
+            ClipAnimator& animator = container.getComponent<ClipAnimator>(e);
+            if(animator.clip == ClipAnimator::NONE)
+                continue;
+
+            const AnimationClip& clip = AnimationClip::get(animator.clip);
+            uint32_t frame = clip.frame(animator.time);
+            if(frame == animator.frame || clip.frames.size() == 0)
+                continue;
 
-            state.setState(animation);
-            animator.setState(state);
-            container.setComponent<AnimatorUV>(e, animator);
+            Model& model = container.getComponent<Model>(e);
+            Transform& transform = container.getComponent<Transform>(e);
+            const Mesh& mesh = model.mesh();
+            if(!frustum.contains(transform.position + mesh.offset, mesh.dimensions.length() * vec3::high(transform.scale)))
+                continue;
+
+            AnimationFrame sample = clip.sample(frame);
+            animator.frame = frame;
+            model.texture = sample.texture;
+            model.offset = sample.offset;
+            model.scale = sample.scale;
         }
     });
 
+    auto& animationsUV = manager.createSystem<AnimationUVManager, AnimatorUV, Model>({}, 24);
+    animationsUV.setFunction(object::fn::START, []
+    (object::ecs & container, object::ecs::system &system, void *data)
+    {
+        registerAnimators<AnimationUVManager, AnimatorUV>(container, Application::data(data).getScene());
+    });
+
     auto& meshes = manager.createSystem<MeshManager, MeshAddon, Transform, Model>({}, 27);
     meshes.setFunction(object::fn::START, []
     (object::ecs & container, object::ecs::system &system, void *data)
@@ -1649,13 +1745,6 @@ void initializeECS(object::ecs& manager)
     });
 
     auto& simpleRendering = manager.createSystem<SimpleRenderer, Transform, Model, SimpleShader>({}, 32);
-    simpleRendering.setFunction(object::fn::LOAD, []
-    (object::ecs &container, object::ecs::system &system, void *data)
-    {
-        SimpleRenderer& renderer = system.getInstance<SimpleRenderer>();
-        std::vector<int *> values = {&renderer.model, &renderer.view, &renderer.projection, &renderer.scale, &renderer.color, &renderer.offset, &renderer.uvScale, &renderer.flip};
-        Shader::get("simple_shader").setUniforms({"model", "view", "projection", "scale", "objColor", "offset", "uvScale", "flip"}, values);
-    });
     simpleRendering.setFunction(object::fn::RENDER, []
     (object::ecs &container, object::ecs::system &system, void *data)
     {
@@ -1668,40 +1757,22 @@ void initializeECS(object::ecs& manager)
         Transform& cameraTransform = container.getComponent<Transform>(cam);
         Frustum frustum = camera.getFrustum(cameraTransform.position, win.aspectRatioInv());
 
-        SimpleRenderer& rendering = system.getInstance<SimpleRenderer>();
         Shader& shader = Shader::get("simple_shader");
-        shader.use();
-
         for(entity e : container.entities<SimpleRenderer>())
         {
-            Model model = container.getComponent<Model>(e);
+            Model& model = container.getComponent<Model>(e);
             Transform& transform = container.getComponent<Transform>(e);
-            if(!frustum.contains(transform.position + model.data.offset, model.data.dimensions.length() * vec3::high(transform.scale)))
+            const Mesh& mesh = model.mesh();
+            if(!frustum.contains(transform.position + mesh.offset, mesh.dimensions.length() * vec3::high(transform.scale)))
                 continue;
                 
             SimpleShader mat = container.getComponent<SimpleShader>(e);
-
-            shader.setMat4(rendering.model, (mat4x4(1).rotated(transform.rotation).translated(transform.position)).matrix, true);
-            shader.setMat4(rendering.view, camera.view.matrix, true);
-            shader.setMat4(rendering.projection, camera.projection.matrix, true);
-            shader.setVec3(rendering.scale, transform.scale);
-            shader.setVec4(rendering.color, mat.color);
-            shader.setVec2(rendering.offset, model.offset);
-            shader.setVec2(rendering.uvScale, model.scale);
-            shader.setBool(rendering.flip, mat.flip);
-
-            model.render();
+            float depth = camera.front.dot(transform.position - cameraTransform.position) / camera.farDistance;
+            win.screen.queue.add(shader, model, Instance(mat4x4(1).rotated(transform.rotation).translated(transform.position), transform.scale, mat.color, model.offset, model.scale, mat.flip), depth);
         }
     });
 
     auto& advancedRendering = manager.createSystem<AdvancedRenderer, Transform, Model, AdvancedShader>({}, 32);
-    advancedRendering.setFunction(object::fn::LOAD, []
-    (object::ecs &container, object::ecs::system &system, void *data)
-    {
-        AdvancedRenderer& renderer = system.getInstance<AdvancedRenderer>();
-        std::vector<int *> values = {&renderer.model, &renderer.view, &renderer.projection, &renderer.scale, &renderer.color, &renderer.viewPos, &renderer.lightDir, &renderer.lightColor, &renderer.lightStr, &renderer.matShininess, &renderer.matAmb, &renderer.matDiff, &renderer.matSpec};
-        Shader::get("object_shader").setUniforms({"model", "view", "projection", "scale", "objColor", "viewPos", "dirLight.direction", "dirLight.color", "dirLight.strength", "material.shininess", "material.ambientStrength", "material.diffuseStrength", "material.specularStrength"}, values);
-    });
     advancedRendering.setFunction(object::fn::RENDER, []
     (object::ecs &container, object::ecs::system &system, void *data)
     {
@@ -1715,70 +1786,33 @@ void initializeECS(object::ecs& manager)
         Frustum frustum = camera.getFrustum(cameraTransform.position, win.aspectRatioInv());
 
         Shader& shader = Shader::get("object_shader");
-        shader.use();
-
         for(entity e : container.entities<AdvancedRenderer>())
         {
-            AdvancedRenderer& rendering = system.getInstance<AdvancedRenderer>();
-            Model model = container.getComponent<Model>(e);
+            Model& model = container.getComponent<Model>(e);
             Transform& transform = container.getComponent<Transform>(e);
-            if(!frustum.contains(transform.position + model.data.offset, model.data.dimensions.length() * vec3::high(transform.scale)))
+            const Mesh& mesh = model.mesh();
+            if(!frustum.contains(transform.position + mesh.offset, mesh.dimensions.length() * vec3::high(transform.scale)))
             {
                 continue;
             }
 
-            DirectionalLight& light = win.screen.dirLight;
             AdvancedShader mat = container.getComponent<AdvancedShader>(e);
-    
-            shader.setMat4(rendering.model, (mat4x4(1).rotated(transform.rotation).translated(transform.position)).matrix, true);
-            shader.setMat4(rendering.view, camera.view.matrix, true);
-            shader.setMat4(rendering.projection, camera.projection.matrix, true);
-            shader.setVec3(rendering.scale, transform.scale);
-            
-            shader.setVec3(rendering.lightDir, light.direction);
-            shader.setVec4(rendering.lightColor, light.color);
-            shader.setFloat(rendering.lightStr, light.strength);
-
-            shader.setVec3(rendering.viewPos, cameraTransform.position);
-            shader.setVec4(rendering.color, mat.color);
-
-            shader.setFloat(rendering.matShininess, mat.shine);
-            shader.setFloat(rendering.matAmb, mat.ambient);
-            shader.setFloat(rendering.matDiff, mat.diffuse);
-            shader.setFloat(rendering.matSpec, mat.specular);
-            model.render();
+            Instance instance(mat4x4(1).rotated(transform.rotation).translated(transform.position), transform.scale, mat.color, model.offset, model.scale, mat.flip);
+            instance.ambient = mat.ambient;
+            instance.diffuse = mat.diffuse;
+            instance.specular = mat.specular;
+            instance.shine = mat.shine;
+
+            float depth = camera.front.dot(transform.position - cameraTransform.position) / camera.farDistance;
+            win.screen.queue.add(shader, model, instance, depth);
         }
     });
 
-    auto& complexRendering = manager.createSystem<ComplexRenderer, Transform, Model, ComplexShader>({}, 33);
-    complexRendering.setFunction(object::fn::LOAD, []
-    (object::ecs &container, object::ecs::system &system, void *data)
-    {
-        ComplexRenderer& renderer = system.getInstance<ComplexRenderer>();
-        renderer.update = true;
-        std::vector<int *> values = {&renderer.model, &renderer.view, &renderer.projection, &renderer.scale, &renderer.color, &renderer.offset, &renderer.uvScale, &renderer.flip};
-        Shader::get("simple_shader").setUniforms({"model", "view", "projection", "scale", "objColor", "offset", "uvScale", "flip"}, values);
-    });
-    complexRendering.setFunction(object::fn::LATE_UPDATE, []
-    (object::ecs &container, object::ecs::system &system, void *data)
-    {
-        uint32_t& cam = (Application::data(data).window()).screen.camera;
-        ComplexRenderer& rendering = system.getInstance<ComplexRenderer>();
-        for(entity e : container.entities<ComplexRenderer>())
-        {
-            Transform& transform = container.getComponent<Transform>(e);
-            if(cam != -1 && math::abs((transform.position - transform.storedPosition).dot(container.getComponent<Camera>(cam).front)) > 0.0001f)
-            {
-                rendering.update = true;
-                break;
-            }
-        }
-    });
+    auto& complexRendering = manager.createSystem<ComplexRenderer, Transform, Model, ComplexShader>({}, 32);
+    // complex models are queued as translucent, so the render queue draws them back to front after every opaque model
     complexRendering.setFunction(object::fn::RENDER, []
     (object::ecs &container, object::ecs::system &system, void *data)
     {
-        glDepthMask(GL_FALSE);
-
         Window& win = Application::data(data).window();
         uint32_t& cam = win.screen.camera;
         if(cam == -1)
@@ -1788,73 +1822,50 @@ void initializeECS(object::ecs& manager)
         Transform& cameraTransform = container.getComponent<Transform>(cam);
         Frustum frustum = camera.getFrustum(cameraTransform.position, win.aspectRatioInv());
         
-        ComplexRenderer& rendering = system.getInstance<ComplexRenderer>();
-        std::vector<entity>& entities = container.entities<ComplexRenderer>();
-        if(rendering.update || vec3::abs(cameraTransform.rotation - cameraTransform.lastRotation).length2() > 0.0001f)
-        {
-            object::insertionSort(entities, container.getMapping<ComplexRenderer>(), (*(Application *)data), container, [](entity one, entity two, object::ecs& container, void *data)
-            {
-                entity cam = (Application::data(data).window()).screen.camera;
-                Camera& camera = container.getComponent<Camera>(cam);
-
-                return camera.front.dot(container.getComponent<Transform>(one).position) < camera.front.dot(container.getComponent<Transform>(two).position);
-            });
-            rendering.update = false;
-        }
-
         Shader& shdr = Shader::get("simple_shader");
 
-        shdr.use();
-
-
-        for(entity e : entities)
+        Shader *fader = nullptr;
+        for(entity e : container.entities<ComplexRenderer>())
         {
-            Model model = container.getComponent<Model>(e);
+            Model& model = container.getComponent<Model>(e);
             Transform& transform = container.getComponent<Transform>(e);
-            if(!frustum.contains(transform.position + model.data.offset, model.data.dimensions.length() * vec3::high(transform.scale)))
+            const Mesh& mesh = model.mesh();
+            if(!frustum.contains(transform.position + mesh.offset, mesh.dimensions.length() * vec3::high(transform.scale)))
             {
                 continue;
             }
 
             ComplexShader mat = container.getComponent<ComplexShader>(e);
+            Instance instance(mat4x4(1).rotated(transform.rotation).translated(transform.position), transform.scale, mat.color, model.offset, model.scale, mat.flip);
+            float depth = camera.front.dot(transform.position - cameraTransform.position) / camera.farDistance;
 
             if(container.containsComponent<Fade>(e))
             {
-                Shader& temp = Shader::get("fade_shader");
-                temp.use();
+                if(!fader)
+                    fader = &Shader::get("fade_shader");
 
+                // the project's "fade_shader" receives the rate and distance in the first two material slots, as documented on Instance
                 Fade& fade = container.getComponent<Fade>(e);
-
-                temp.setMat4("model", (mat4x4(1).rotated(transform.rotation).translated(transform.position)).matrix, true);
-                temp.setMat4("view", camera.view.matrix, true);
-                temp.setMat4("projection", camera.projection.matrix, true);
-                temp.setVec3("scale", transform.scale);
-                temp.setVec4("objColor", mat.color);
-                temp.setVec2("offset", model.offset);
-                temp.setVec2("uvScale", model.scale);
-                temp.setBool("flip", mat.flip);
-                temp.setFloat("rate", fade.rate);
-                temp.setFloat("distance", fade.distance);
-
-                model.render();
-
-                shdr.use();
+                instance.ambient = fade.rate;
+                instance.diffuse = fade.distance;
+                win.screen.queue.add(*fader, model, instance, depth, true);
             }
             else
             {
-                shdr.setMat4(rendering.model, (mat4x4(1).rotated(transform.rotation).translated(transform.position)).matrix, true);
-                shdr.setMat4(rendering.view, camera.view.matrix, true);
-                shdr.setMat4(rendering.projection, camera.projection.matrix, true);
-                shdr.setVec3(rendering.scale, transform.scale);
-                shdr.setVec4(rendering.color, mat.color);
-                shdr.setVec2(rendering.offset, model.offset);
-                shdr.setVec2(rendering.uvScale, model.scale);
-                shdr.setBool(rendering.flip, mat.flip);
-
-                model.render();
+                win.screen.queue.add(shdr, model, instance, depth, true);
             }
         }
-        glDepthMask(GL_TRUE);
+    });
+
+    auto& renderQueue = manager.createSystem<RenderQueueManager>({}, 33);
+    renderQueue.setFunction(object::fn::RENDER, []
+    (object::ecs &container, object::ecs::system &system, void *data)
+    {
+        Window& win = Application::data(data).window();
+        Screen& screen = win.screen;
+        if(screen.camera != -1)
+            screen.updateBlocks(container.getComponent<Camera>(screen.camera), container.getComponent<Transform>(screen.camera).position, win.aspectRatioInv());
+        screen.queue.submit();
     });
 
     auto& uiRendering = manager.createSystem<UIRenderer, Rect, Sprite, SimpleShader>({}, 34);
@@ -1880,10 +1891,10 @@ void initializeECS(object::ecs& manager)
         Shader& shader = Shader::get("ui_shader");
         shader.use();
 
-        glDisable(GL_DEPTH_TEST);
+        glstate::depthTest(false);
         for(entity e : container.entities<UIRenderer>())
         {
-            Sprite sprite = container.getComponent<Sprite>(e);
+            const Sprite& sprite = container.getComponent<Sprite>(e);
             Rect& rect = container.getComponent<Rect>(e);
             SimpleShader mat = container.getComponent<SimpleShader>(e);
 
@@ -1895,7 +1906,7 @@ void initializeECS(object::ecs& manager)
 
             sprite.render();
         }
-        glEnable(GL_DEPTH_TEST);
+        glstate::depthTest(true);
     });
 
     auto& textRendering = manager.createSystem<TextRenderer, Text, Rect>({}, 36);
@@ -1912,7 +1923,7 @@ void initializeECS(object::ecs& manager)
         Shader& shader = Shader::get("text_shader");
         shader.use();
 
-        glDisable(GL_DEPTH_TEST);
+        glstate::depthTest(false);
         for(entity e : container.entities<TextRenderer>())
         {
             Text text = container.getComponent<Text>(e);
@@ -1927,7 +1938,7 @@ void initializeECS(object::ecs& manager)
 
             // sprite.render();
         }
-        glEnable(GL_DEPTH_TEST);
+        glstate::depthTest(true);
     });
 
     auto& cameras = manager.createSystem<CameraManager, Camera, Transform>({}, 36);
@@ -2040,6 +2051,297 @@ void initializeECS(object::ecs& manager)
     });
 }
 
+WorldPartition::WorldPartition(const std::string& directory__, float cellSize__, float loadDistance__, float unloadDistance__, size_t memoryBudget__)
+{
+    directory = directory__;
+    cellSize = cellSize__;
+    loadDistance = loadDistance__;
+    unloadDistance = std::max(unloadDistance__, loadDistance__);
+    memoryBudget = memoryBudget__;
+}
+
+bool WorldPartition::save(const std::string& directory, const Vector2I& cell, const object::ecs& chunk)
+{
+    std::vector<uint8_t> stream(object::length(chunk));
+    object::serialize(chunk, stream, 0);
+    return file::saveBytes(directory + "/" + std::to_string(cell.x) + "_" + std::to_string(cell.y) + ".cell", stream, true);
+}
+
+Vector2I WorldPartition::cellAt(const Vector3& position) const
+{
+    return Vector2I(std::floor(position.x / cellSize), std::floor(position.z / cellSize));
+}
+
+uint64_t WorldPartition::key(const Vector2I& cell)
+{
+    return ((uint64_t)(uint32_t)cell.x << 32) | (uint32_t)cell.y;
+}
+
+std::string WorldPartition::path(const Vector2I& cell) const
+{
+    return directory + "/" + std::to_string(cell.x) + "_" + std::to_string(cell.y) + ".cell";
+}
+
+float WorldPartition::distance(const Vector2I& cell, const Vector3& position) const
+{
+    float x = (cell.x + 0.5f) * cellSize - position.x;
+    float z = (cell.y + 0.5f) * cellSize - position.z;
+    return std::sqrt(x * x + z * z);
+}
+
+void WorldPartition::unload(object::ecs& container, Cell& cell)
+{
+    for(entity e : cell.entities)
+    {
+        if(container.containsComponent<PartitionCell>(e) && container.getComponent<PartitionCell>(e).key == cell.key)
+            container.removeEntity(e);
+    }
+    cell.entities.clear();
+    cell.state = UNLOADED;
+    resident -= cell.bytes;
+}
+
+void WorldPartition::update(object::ecs& container, const Vector3& position)
+{
+    if(directory.empty())
+        return;
+
+    // merges finished cells; a cell that does not fit the budget evicts farther cells or is dropped until space frees up
+    for(auto& [id, cell] : cells)
+    {
+        if(cell.state != LOADING || cell.chunk.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+
+        Chunk chunk = cell.chunk.get();
+        if(!chunk.found)
+        {
+            cell.state = MISSING;
+            continue;
+        }
+        cell.bytes = chunk.bytes;
+
+        Vector2I coordinates((int32_t)(id >> 32), (int32_t)(uint32_t)id);
+        float range = distance(coordinates, position);
+        while(resident + cell.bytes > memoryBudget)
+        {
+            Cell *farthest = nullptr;
+            float farthestRange = range;
+            for(auto& [otherId, other] : cells)
+            {
+                float otherRange = distance(Vector2I((int32_t)(otherId >> 32), (int32_t)(uint32_t)otherId), position);
+                if(other.state == LOADED && otherRange > farthestRange)
+                {
+                    farthest = &other;
+                    farthestRange = otherRange;
+                }
+            }
+            if(!farthest)
+                break;
+            unload(container, *farthest);
+        }
+
+        if(resident + cell.bytes > memoryBudget)
+        {
+            cell.state = UNLOADED;
+            continue;
+        }
+
+        std::vector<entity> remap = container.merge(chunk.container);
+        for(entity e : remap)
+        {
+            if(e == -1)
+                continue;
+
+            if(container.containsComponent<PartitionCell>(e))
+                container.getComponent<PartitionCell>(e).key = id;
+            else
+                container.addComponent<PartitionCell>(e, {id});
+            cell.entities.push_back(e);
+        }
+        if(merged)
+        {
+            merged(container, remap);
+        }
+        cell.state = LOADED;
+        resident += cell.bytes;
+    }
+
+    // cells past 'unloadDistance' are forgotten once unloaded, so the map only holds cells near the camera and a missing cell is looked for again on return
+    for(auto it = cells.begin(); it != cells.end();)
+    {
+        Cell& cell = it->second;
+        if(cell.state == LOADING || distance(Vector2I((int32_t)(it->first >> 32), (int32_t)(uint32_t)it->first), position) <= unloadDistance)
+        {
+            it++;
+            continue;
+        }
+
+        if(cell.state == LOADED)
+            unload(container, cell);
+        it = cells.erase(it);
+    }
+
+    Vector2I center = cellAt(position);
+    int32_t radius = std::ceil(loadDistance / cellSize);
+    for(int32_t x = center.x - radius; x <= center.x + radius; x++)
+    {
+        for(int32_t z = center.y - radius; z <= center.y + radius; z++)
+        {
+            Vector2I coordinates(x, z);
+            if(distance(coordinates, position) > loadDistance)
+                continue;
+
+            Cell& cell = cells[key(coordinates)];
+            cell.key = key(coordinates);
+            if(cell.state != UNLOADED || resident + cell.bytes > memoryBudget)
+                continue;
+
+            // reading and decoding happen on a worker; only the merge touches the live scene
+            cell.state = LOADING;
+            cell.chunk = std::async(std::launch::async, [file = path(coordinates)]()
+            {
+                Chunk chunk;
+                if(!std::filesystem::exists(Source::root() + file))
+                    return chunk;
+
+                std::vector<uint8_t> stream = file::loadFileToBytes(file, true);
+                chunk.bytes = stream.size();
+                chunk.found = chunk.bytes > 0;
+                if(chunk.found)
+                {
+                    chunk.container = object::deserialize<object::ecs>(stream, 0);
+                }
+                return chunk;
+            });
+        }
+    }
+}
+
+void WorldPartition::clear(object::ecs *container)
+{
+    for(auto& [id, cell] : cells)
+    {
+        if(cell.state == LOADING)
+        {
+            cell.chunk.wait();
+        }
+        else if(cell.state == LOADED && container)
+        {
+            unload(*container, cell);
+        }
+    }
+    cells.clear();
+    resident = 0;
+}
+
+void Scene::updateMachines()
+{
+    registerAnimators<AnimationManager, Animator2D>(container, *this);
+    registerAnimators<AnimationUVManager, AnimatorUV>(container, *this);
+
+    for(uint32_t i = 0; i < machines.size(); i++)
+    {
+        // entities are not told when they are destroyed, so rows whose owner no longer points back at them are dropped here
+        object::MachineBatch& batch = machines[i].machine;
+        for(uint32_t index = batch.size(); index-- > 0;)
+        {
+            uint32_t owner = batch.owners[index];
+            if(!container.containsComponent<ClipAnimator>(owner))
+            {
+                releaseMachine(i, index);
+                continue;
+            }
+            ClipAnimator& animator = container.getComponent<ClipAnimator>(owner);
+            if(animator.machine != i || animator.instance != index)
+                releaseMachine(i, index);
+        }
+    }
+
+    for(uint32_t i = 0; i < machines.size(); i++)
+    {
+        AnimatorBatch& batch = machines[i];
+        for(const object::MachineChange& change : batch.machine.evaluate())
+        {
+            ClipAnimator& animator = container.getComponent<ClipAnimator>(change.owner);
+            animator.clip = change.target < batch.clips.size() ? batch.clips[change.target] : ClipAnimator::NONE;
+            animator.time = 0;
+            animator.frame = ClipAnimator::NONE;
+        }
+    }
+}
+
+uint32_t Scene::addMachine(entity e, const object::MachineBatch& machine, const std::vector<uint32_t>& clips, const std::vector<std::vector<uint32_t>>& offsets)
+{
+    if(!container.containsComponent<ClipAnimator>(e))
+        container.addComponent<ClipAnimator>(e, ClipAnimator());
+    removeMachine(e);
+
+    AnimatorBatch candidate;
+    candidate.machine = machine;
+    candidate.clips = clips;
+    candidate.offsets = offsets;
+    candidate.key.resize(object::length(machine) + object::length(clips) + object::length(offsets));
+    size_t count = object::serialize(machine, candidate.key, 0);
+    count += object::serialize(clips, candidate.key, count);
+    object::serialize(offsets, candidate.key, count);
+
+    uint32_t batch = 0;
+    while(batch < machines.size() && machines[batch].key != candidate.key)
+        batch++;
+    if(batch == machines.size())
+        machines.push_back(std::move(candidate));
+
+    AnimatorBatch& shared = machines[batch];
+    ClipAnimator& animator = container.getComponent<ClipAnimator>(e);
+    animator.machine = batch;
+    animator.instance = shared.machine.add(e);
+    animator.clip = shared.machine.initial < shared.clips.size() ? shared.clips[shared.machine.initial] : ClipAnimator::NONE;
+    animator.time = 0;
+    animator.frame = ClipAnimator::NONE;
+    return batch;
+}
+
+void Scene::removeMachine(entity e)
+{
+    uint32_t batch, index;
+    if(locateMachine(e, batch, index))
+        releaseMachine(batch, index);
+    if(container.containsComponent<ClipAnimator>(e))
+    {
+        ClipAnimator& animator = container.getComponent<ClipAnimator>(e);
+        animator.machine = ClipAnimator::NONE;
+        animator.instance = ClipAnimator::NONE;
+    }
+}
+
+bool Scene::locateMachine(entity e, uint32_t& batch, uint32_t& index)
+{
+    if(!container.containsComponent<ClipAnimator>(e))
+        return false;
+
+    ClipAnimator& animator = container.getComponent<ClipAnimator>(e);
+    batch = animator.machine;
+    index = animator.instance;
+    return batch < machines.size() && index < machines[batch].machine.size() && machines[batch].machine.owners[index] == e;
+}
+
+void Scene::releaseMachine(uint32_t batch, uint32_t index)
+{
+    object::MachineBatch& machine = machines[batch].machine;
+    uint32_t last = machine.size() - 1;
+    machine.remove(index);
+    if(index == last)
+        return;
+
+    entity moved = machine.owners[index];
+    if(container.containsComponent<ClipAnimator>(moved))
+    {
+        ClipAnimator& animator = container.getComponent<ClipAnimator>(moved);
+        if(animator.machine == batch && animator.instance == last)
+            animator.instance = index;
+    }
+}
+
 Scene::Scene(const object::ecs& container__)
 {
     container = container__;
@@ -2051,8 +2353,8 @@ Scene::Scene(const object::ecs& container__)
     container.addToToggle<AABBHandler>(pause, object::fn::UPDATE);
     container.addToToggle<AABB2DHandler>(pause, object::fn::UPDATE);
     container.addToToggle<BillboardManager>(pause, object::fn::LATE_UPDATE);
-    container.addToToggle<AnimationManager>(pause, object::fn::FIXED_UPDATE);
-    container.addToToggle<AnimationUVManager>(pause, object::fn::FIXED_UPDATE);
+    container.addToToggle<ClipManager>(pause, object::fn::UPDATE);
+    container.addToToggle<ClipManager>(pause, object::fn::FIXED_UPDATE);
 }
 
 
@@ -2098,8 +2400,14 @@ Application::Application(const std::string& name, uint32_t width, uint32_t heigh
         }
     }
 
+    Shader::bindBlock("Camera", CameraBlock::BINDING);
+    Shader::bindBlock("Lights", LightBlock::BINDING);
+
     Shader::get("object_shader").use();
     Shader::get("object_shader").setInt("material.diffuse", 0);
+    Shader::get("object_shader").setInt("lightData", 1);
+    Shader::get("object_shader").setInt("lightGrid", 2);
+    Shader::get("object_shader").setInt("lightIndices", 3);
     
     Shader::get("simple_shader").use();
     Shader::get("simple_shader").setInt("material.texture", 0);
@@ -2184,21 +2492,159 @@ Scene& Application::getScene()
     return scenes[currentScene];
 }
 
+void Application::loadSceneAsync(uint32_t scene)
+{
+    if(scene >= scenes.size())
+    {
+        std::cout << "ERROR :: Scene does not exist.\n";
+        return;
+    }
+    if(loader.scene != -1)
+    {
+        std::cout << "ERROR :: A scene is already being loaded.\n";
+        return;
+    }
+    if(scene == currentScene)
+    {
+        std::cout << "ERROR :: The current scene cannot be loaded asynchronously.\n";
+        return;
+    }
+
+    loader.scene = scene;
+    loader.stage = SceneLoader::PREPARING;
+    assets.reset();
+
+    // the copy is made on the main thread; the worker only touches its own world and the asset loader
+    loader.preparation = std::async(std::launch::async, [loading = &assets, container = scenes[scene].container]() mutable
+    {
+        container.run(object::fn::PREPARE, loading);
+        return std::move(container);
+    });
+}
+
+float Application::loadProgress() const
+{
+    if(loader.scene == -1)
+        return 1;
+
+    bool ready = loader.preparation.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    if(loader.stage == SceneLoader::PREPARING)
+        return ready ? (1 + assets.progress()) / 3.0f : assets.progress() / 3.0f;
+    return ready ? 1 : 2 / 3.0f;
+}
+
+void AssetLoader::preloadMesh(const std::string& path, bool compact)
+{
+    Mesh mesh = file::loadObjFile(path, compact);
+
+    std::lock_guard<std::mutex> guard(lock);
+    meshes.push_back({path, mesh});
+    queued++;
+}
+
+void AssetLoader::preloadTexture(const std::string& path, Texture::Type type, Texture::Filter filter)
+{
+    Texture::Image image = Texture::decode(path);
+
+    std::lock_guard<std::mutex> guard(lock);
+    textures.push_back({path, std::move(image), type, filter});
+    queued++;
+}
+
+bool AssetLoader::upload(double budget)
+{
+    double start = glfwGetTime();
+    while(glfwGetTime() - start < budget)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if(meshes.size())
+        {
+            std::pair<std::string, Mesh> mesh = std::move(meshes.back());
+            meshes.pop_back();
+            guard.unlock();
+
+            // the mesh is uploaded here so that nothing is left for START on the switch frame
+            Mesh::load(mesh.first, mesh.second).refresh();
+        }
+        else if(textures.size())
+        {
+            TextureUpload texture = std::move(textures.back());
+            textures.pop_back();
+            guard.unlock();
+
+            Texture::upload(texture.path, texture.image, texture.type, texture.filter);
+        }
+        else
+        {
+            break;
+        }
+        uploaded++;
+    }
+
+    return uploaded == queued;
+}
+
+void Application::updateLoader()
+{
+    std::erase_if(loader.retired, [](const std::future<void>& retiring)
+    {
+        return retiring.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+
+    bool uploaded = assets.upload(uploadBudget);
+    if(loader.scene == -1)
+        return;
+
+    bool ready = loader.preparation.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    if(!ready || !uploaded)
+        return;
+
+    if(loader.stage == SceneLoader::PREPARING)
+    {
+        // every asset PREPARE asked for is registered now, so BUILD finds it when it looks it up from the worker
+        loader.stage = SceneLoader::BUILDING;
+        loader.preparation = std::async(std::launch::async, [loading = &assets, container = loader.preparation.get()]() mutable
+        {
+            container.run(object::fn::BUILD, loading);
+            return std::move(container);
+        });
+        return;
+    }
+
+    // the worker has finished, so the built world can be swapped in without blocking
+    scenes[loader.scene].container = loader.preparation.get();
+    setScene(loader.scene);
+    loader.built = true;
+    loader.scene = -1;
+}
+
 void Application::updateScene()
 {
+    updateLoader();
+
     if(sceneChanged)
     {
         if(lastScene != -1)
         {
             object::ecs& last = scenes[lastScene].container;
             last.run(object::fn::DESTROY, this);
-            last.clearEntities();
+            scenes[lastScene].partition.clear(nullptr);
+            scenes[lastScene].machines.clear();
+
+            // freeing a large world can take longer than a frame, so it is handed to a worker
+            loader.retired.push_back(std::async(std::launch::async, [world = last.releaseEntities()]() mutable
+            {
+                world = object::ecs();
+            }));
         }
 
         object::ecs& current = scenes[currentScene].container;
+        if(!loader.built)
+            current.run(object::fn::BUILD, &assets);
         current.run(object::fn::LOAD, this);
         current.run(object::fn::START, this);
 
+        loader.built = false;
         sceneChanged = false;
     }
 }
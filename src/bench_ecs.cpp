@@ -0,0 +1,249 @@
+#include "structure.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// venus_bench_ecs :: headless micro-benchmarks for 'object::ecs'
+// usage: venus_bench_ecs [--max entities] [--samples count] [--csv file] [--json file]
+
+namespace
+{
+    struct Position { float x, y, z; };
+    struct Velocity { float x, y, z; };
+    struct Health { int32_t current, maximum; };
+    struct Tag { uint32_t value; };
+
+    // a non-trivially-copyable component, stored serialized inside its pool
+    struct Label
+    {
+        std::string text;
+
+        static size_t length(const Label& value)
+        {
+            return object::length(value.text);
+        }
+
+        static size_t serialize(const Label& value, std::vector<uint8_t>& stream, size_t index)
+        {
+            return object::serialize(value.text, stream, index);
+        }
+
+        static Label deserialize(std::vector<uint8_t>& stream, size_t index)
+        {
+            return {object::deserialize<std::string>(stream, index)};
+        }
+    };
+
+    struct Gather2 {};
+    struct Gather3 {};
+    struct Gather4 {};
+    struct Movement {};
+
+    struct Result
+    {
+        std::string name;
+        size_t entities;
+        size_t operations;
+        double milliseconds;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // keeps the optimizer from discarding the results of iteration benchmarks
+    volatile float sink = 0;
+
+    void populate(object::ecs& ecs, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            entity e = ecs.createEntity();
+            ecs.addComponent<Position>(e, {(float)i, 0, 0});
+            ecs.addComponent<Velocity>(e, {1, 0, 0});
+            ecs.addComponent<Health>(e, {100, 100});
+            ecs.addComponent<Tag>(e, {(uint32_t)i});
+        }
+    }
+
+    void run(size_t count, size_t samples, std::vector<Result>& results)
+    {
+        // removals and serialized writes shift the pool behind them, so they are sampled instead of run `count` times
+        size_t sampled = std::min(count, samples);
+
+        {
+            object::ecs ecs;
+            Clock::time_point start = Clock::now();
+            for(size_t i = 0; i < count; i++)
+            {
+                ecs.createEntity();
+            }
+            results.push_back({"createEntity", count, count, elapsed(start)});
+
+            start = Clock::now();
+            for(size_t i = 0; i < sampled; i++)
+            {
+                ecs.removeEntity(count - 1 - i);
+            }
+            results.push_back({"removeEntity", count, sampled, elapsed(start)});
+        }
+
+        {
+            object::ecs ecs;
+            for(size_t i = 0; i < count; i++)
+            {
+                ecs.createEntity();
+            }
+
+            Clock::time_point start = Clock::now();
+            for(size_t i = 0; i < count; i++)
+            {
+                ecs.addComponent<Position>(i, {(float)i, 0, 0});
+            }
+            results.push_back({"addComponent", count, count, elapsed(start)});
+
+            start = Clock::now();
+            for(size_t i = 0; i < sampled; i++)
+            {
+                ecs.removeComponent<Position>(count - 1 - i);
+            }
+            results.push_back({"removeComponent", count, sampled, elapsed(start)});
+        }
+
+        {
+            object::ecs ecs;
+            for(size_t i = 0; i < count; i++)
+            {
+                entity e = ecs.createEntity();
+                ecs.addComponent<Label>(e, {"label"});
+            }
+
+            Clock::time_point start = Clock::now();
+            for(size_t i = 0; i < sampled; i++)
+            {
+                ecs.setComponent<Label>(i * (count / sampled), {"a longer label " + std::to_string(i)});
+            }
+            results.push_back({"setComponent(serialized)", count, sampled, elapsed(start)});
+        }
+
+        {
+            object::ecs ecs;
+            populate(ecs, count);
+
+            Clock::time_point start = Clock::now();
+            ecs.createSystem<Movement, Position, Velocity>();
+            results.push_back({"createSystem(populated)", count, 1, elapsed(start)});
+
+            ecs.createSystem<Gather2, Position, Velocity>();
+            ecs.createSystem<Gather3, Position, Velocity, Health>();
+            ecs.createSystem<Gather4, Position, Velocity, Health, Tag>();
+
+            start = Clock::now();
+            float total = 0;
+            for(entity e : ecs.entities<Gather2>())
+            {
+                Position& position = ecs.getComponent<Position>(e);
+                position.x += ecs.getComponent<Velocity>(e).x;
+                total += position.x;
+            }
+            results.push_back({"iterate(2 components)", count, count, elapsed(start)});
+
+            start = Clock::now();
+            for(entity e : ecs.entities<Gather3>())
+            {
+                Position& position = ecs.getComponent<Position>(e);
+                position.x += ecs.getComponent<Velocity>(e).x;
+                total += position.x * ecs.getComponent<Health>(e).current;
+            }
+            results.push_back({"iterate(3 components)", count, count, elapsed(start)});
+
+            start = Clock::now();
+            for(entity e : ecs.entities<Gather4>())
+            {
+                Position& position = ecs.getComponent<Position>(e);
+                position.x += ecs.getComponent<Velocity>(e).x;
+                total += position.x * ecs.getComponent<Health>(e).current + ecs.getComponent<Tag>(e).value;
+            }
+            results.push_back({"iterate(4 components)", count, count, elapsed(start)});
+            sink = total;
+        }
+    }
+
+    std::string csv(const std::vector<Result>& results)
+    {
+        std::string content = "benchmark,entities,operations,total_ms,ns_per_op\n";
+        for(const Result& result : results)
+        {
+            content += result.name + "," + std::to_string(result.entities) + "," + std::to_string(result.operations) + "," +
+                std::to_string(result.milliseconds) + "," + std::to_string(result.milliseconds * 1e6 / result.operations) + "\n";
+        }
+        return content;
+    }
+
+    std::string json(const std::vector<Result>& results)
+    {
+        std::string content = "[\n";
+        for(size_t i = 0; i < results.size(); i++)
+        {
+            const Result& result = results[i];
+            content += "  {\"benchmark\": \"" + result.name + "\", \"entities\": " + std::to_string(result.entities) + ", \"operations\": " +
+                std::to_string(result.operations) + ", \"total_ms\": " + std::to_string(result.milliseconds) + ", \"ns_per_op\": " +
+                std::to_string(result.milliseconds * 1e6 / result.operations) + "}" + (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        return content + "]\n";
+    }
+
+    bool write(const std::string& path, const std::string& content)
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if(!file.is_open())
+        {
+            std::cout << "ERROR :: " << path << " could not be opened." << std::endl;
+            return false;
+        }
+        file << content;
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t maximum = 1000000, samples = 1000;
+    std::string csvPath, jsonPath;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if(option == "--max")
+            maximum = std::stoull(argv[i + 1]);
+        else if(option == "--samples")
+            samples = std::stoull(argv[i + 1]);
+        else if(option == "--csv")
+            csvPath = argv[i + 1];
+        else if(option == "--json")
+            jsonPath = argv[i + 1];
+        else
+        {
+            std::cout << "ERROR :: Unknown option '" << option << "'." << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for(size_t count = 1000; count <= maximum; count *= 10)
+    {
+        run(count, samples, results);
+    }
+
+    std::cout << csv(results);
+    if(csvPath.size() && !write(csvPath, csv(results)))
+        return 1;
+    if(jsonPath.size() && !write(jsonPath, json(results)))
+        return 1;
+    return 0;
+}
@@ -36,15 +36,20 @@ void Application::runEventLoop(Application& app)
 
         
         app.time.update();
-        while(app.time.timer > 0.02f)
+        while(app.time.timer > Time::FIXED_STEP)
         {
             ecs.run(object::fn::FIXED_UPDATE, &app);
-            app.time.resetTimer(0.02f);
+            app.time.resetTimer(Time::FIXED_STEP);
         }
         
         ecs.run(object::fn::UPDATE, &app);
         ecs.run(object::fn::LATE_UPDATE, &app);
 
+        if(camera != -1)
+        {
+            app.getScene().partition.update(ecs, ecs.getComponent<Transform>(camera).position);
+        }
+
         window.screen.store();
         if(camera != -1)
         {
@@ -96,6 +101,7 @@ void Application::runEventLoop(Application& app)
     // Audio::clear();
 
     std::cout << app.time.framerate() << " FPS : " << app.time.deltaTime*1000 << " ms\n";
+    std::cout << glstate::counters().issued << " issued : " << glstate::counters().elided << " elided (GL state)\n";
     window.throwError();
     // win.throwAudioError();
     std::cout << ecs.parseError() << " (ECS)" << std::endl;
@@ -1,9 +1,13 @@
 #define NOMINMAX
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <algorithm>
+#include <bit>
 #include <bitset>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
 
 #if defined(_WIN32)
@@ -59,7 +63,406 @@ std::vector<std::string> file::loadFileToStringVector(const std::string &fileNam
     return content;
 }
 
-Mesh file::loadObjFile(const std::string &fileName)
+std::vector<uint8_t> file::loadFileToBytes(const std::string &fileName, bool decompress, size_t threads)
+{
+    std::vector<uint8_t> content;
+    std::ifstream myFile;
+
+    myFile.open(Source::root()+fileName, std::ios::binary | std::ios::ate);
+    if(myFile.is_open())
+    {
+        content.resize(myFile.tellg());
+        myFile.seekg(0);
+        myFile.read((char *)content.data(), content.size());
+        myFile.close();
+    }
+    else
+    {
+        std::cout << "ERROR :: " << Source::root()+fileName << " could not be opened." << std::endl;
+    }
+
+    if(decompress && content.size())
+    {
+        std::vector<uint8_t> result;
+        if(!compression::decompress(content, result, threads))
+        {
+            std::cout << "ERROR :: " << Source::root()+fileName << " is not a valid compressed file." << std::endl;
+            return std::vector<uint8_t>();
+        }
+        return result;
+    }
+    return content;
+}
+
+bool file::saveBytes(const std::string &fileName, const std::vector<uint8_t>& data, bool compress, size_t threads)
+{
+    std::ofstream myFile;
+
+    myFile.open(Source::root()+fileName, std::ios::binary | std::ios::trunc);
+    if(!myFile.is_open())
+    {
+        std::cout << "ERROR :: " << Source::root()+fileName << " could not be opened." << std::endl;
+        return false;
+    }
+
+    if(compress)
+    {
+        std::vector<uint8_t> frame = compression::compress(data, threads);
+        myFile.write((const char *)frame.data(), frame.size());
+    }
+    else
+    {
+        myFile.write((const char *)data.data(), data.size());
+    }
+    return true;
+}
+
+// frame :: magic, uncompressed size (uint64), block count (uint32), one uint32 length per block, then the blocks
+// a block length with RAW_BLOCK set is a block stored uncompressed
+namespace
+{
+    constexpr uint8_t MAGIC[4] = {'V', 'L', 'Z', '1'};
+    constexpr size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint64_t) + sizeof(uint32_t);
+    constexpr uint32_t RAW_BLOCK = 0x80000000u;
+
+    // a block ends with at least this many literals, and the last match starts at least MATCH_LIMIT bytes before its end
+    constexpr size_t LAST_LITERALS = 5, MATCH_LIMIT = 12, MIN_MATCH = 4;
+    constexpr size_t MAX_OFFSET = 65535;
+    constexpr uint32_t HASH_LOG = 14;
+
+    uint32_t read32(const uint8_t *data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    // counts the bytes 'first' and 'second' have in common, up to 'limit'
+    size_t matchLength(const uint8_t *first, const uint8_t *second, size_t limit)
+    {
+        size_t length = 0;
+        if constexpr(std::endian::native == std::endian::little)
+        {
+            while(length + sizeof(uint64_t) <= limit)
+            {
+                uint64_t a, b;
+                std::memcpy(&a, first + length, sizeof(a));
+                std::memcpy(&b, second + length, sizeof(b));
+                if(a != b)
+                {
+                    return length + std::countr_zero(a ^ b) / 8;
+                }
+                length += sizeof(uint64_t);
+            }
+        }
+        while(length < limit && first[length] == second[length])
+        {
+            length++;
+        }
+        return length;
+    }
+
+    // writes the extra bytes of a length that did not fit in its 4-bit token field
+    uint8_t *writeLength(uint8_t *out, size_t length)
+    {
+        for(; length >= 255; length -= 255)
+        {
+            *out++ = 255;
+        }
+        *out++ = (uint8_t)length;
+        return out;
+    }
+
+    // reads the extra bytes of a length whose token field was 15 :: returns false if the block ends first
+    bool readLength(const uint8_t *&in, const uint8_t *end, size_t& length)
+    {
+        uint8_t byte;
+        do
+        {
+            if(in == end)
+                return false;
+            byte = *in++;
+            length += byte;
+        } while(byte == 255);
+        return true;
+    }
+
+    // splits blocks [0, count) between up to 'threads' workers :: returns false if any call to 'work' did
+    template<typename F>
+    bool forBlocks(size_t count, size_t threads, F work)
+    {
+        threads = std::max<size_t>(1, std::min(threads, count));
+        if(threads == 1)
+        {
+            for(size_t i = 0; i < count; i++)
+            {
+                if(!work(i))
+                    return false;
+            }
+            return true;
+        }
+
+        std::vector<std::future<bool>> workers;
+        for(size_t t = 0; t < threads; t++)
+        {
+            workers.push_back(std::async(std::launch::async, [&, t]()
+            {
+                bool result = true;
+                for(size_t i = t; i < count; i += threads)
+                {
+                    result = work(i) && result;
+                }
+                return result;
+            }));
+        }
+
+        bool result = true;
+        for(auto& worker : workers)
+        {
+            result = worker.get() && result;
+        }
+        return result;
+    }
+}
+
+size_t compression::compressBlock(const uint8_t *source, size_t size, uint8_t *destination, size_t capacity)
+{
+    std::vector<uint32_t> table(1 << HASH_LOG, 0);
+    uint8_t *out = destination, *outEnd = destination + capacity;
+    size_t anchor = 0;
+
+    // writes the literals since 'anchor' followed by a match of 'length' at 'offset' (none if 'length' is 0)
+    auto sequence = [&](size_t literals, size_t offset, size_t length) -> bool
+    {
+        // the token, the literals, their extra length bytes, the offset, and the match's extra length bytes
+        size_t worst = 1 + literals + literals / 255 + 1 + 2 + length / 255 + 1;
+        if(worst > (size_t)(outEnd - out))
+            return false;
+
+        uint8_t *token = out++;
+        *token = (uint8_t)(std::min<size_t>(literals, 15) << 4);
+        if(literals >= 15)
+            out = writeLength(out, literals - 15);
+        std::memcpy(out, source + anchor, literals);
+        out += literals;
+
+        if(length)
+        {
+            *out++ = (uint8_t)offset;
+            *out++ = (uint8_t)(offset >> 8);
+            size_t extra = length - MIN_MATCH;
+            *token |= (uint8_t)std::min<size_t>(extra, 15);
+            if(extra >= 15)
+                out = writeLength(out, extra - 15);
+        }
+        return true;
+    };
+
+    if(size > MATCH_LIMIT)
+    {
+        size_t position = 1, limit = size - MATCH_LIMIT;
+        table[hash(read32(source))] = 0;
+
+        while(position < limit)
+        {
+            uint32_t current = read32(source + position);
+            uint32_t& slot = table[hash(current)];
+            size_t candidate = slot;
+            slot = (uint32_t)position;
+
+            if(position - candidate > MAX_OFFSET || read32(source + candidate) != current)
+            {
+                // skips ahead faster the longer nothing has matched
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            while(position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1])
+            {
+                position--;
+                candidate--;
+            }
+
+            size_t length = MIN_MATCH + matchLength(source + position + MIN_MATCH, source + candidate + MIN_MATCH, size - LAST_LITERALS - position - MIN_MATCH);
+            if(!sequence(position - anchor, position - candidate, length))
+                return 0;
+
+            position += length;
+            anchor = position;
+            if(position < limit)
+            {
+                table[hash(read32(source + position - 2))] = (uint32_t)(position - 2);
+            }
+        }
+    }
+
+    if(!sequence(size - anchor, 0, 0))
+        return 0;
+    return out - destination;
+}
+
+bool compression::decompressBlock(const uint8_t *source, size_t length, uint8_t *destination, size_t size)
+{
+    const uint8_t *in = source, *inEnd = source + length;
+    uint8_t *out = destination, *outEnd = destination + size;
+
+    while(in < inEnd)
+    {
+        uint8_t token = *in++;
+
+        size_t literals = token >> 4;
+        if(literals == 15 && !readLength(in, inEnd, literals))
+            return false;
+        if(literals > (size_t)(inEnd - in) || literals > (size_t)(outEnd - out))
+            return false;
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+
+        // the last sequence has no match
+        if(in == inEnd)
+            break;
+
+        if(inEnd - in < 2)
+            return false;
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        if(offset == 0 || offset > (size_t)(out - destination))
+            return false;
+
+        size_t match = token & 15;
+        if(match == 15 && !readLength(in, inEnd, match))
+            return false;
+        match += MIN_MATCH;
+        if(match > (size_t)(outEnd - out))
+            return false;
+
+        // an overlapping match repeats the last 'offset' bytes; each copy doubles the repeated run behind 'out'
+        for(size_t distance = offset; match;)
+        {
+            size_t step = std::min(distance, match);
+            std::memcpy(out, out - distance, step);
+            out += step;
+            match -= step;
+            distance += step;
+        }
+    }
+    return out == outEnd;
+}
+
+bool compression::compressed(const std::vector<uint8_t>& data)
+{
+    return data.size() >= HEADER_SIZE && std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+std::vector<uint8_t> compression::compress(const std::vector<uint8_t>& data, size_t threads)
+{
+    uint32_t count = (uint32_t)((data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    std::vector<std::vector<uint8_t>> blocks(count);
+    std::vector<uint32_t> lengths(count);
+
+    forBlocks(count, threads, [&](size_t i)
+    {
+        size_t size = std::min(BLOCK_SIZE, data.size() - i * BLOCK_SIZE);
+        const uint8_t *source = data.data() + i * BLOCK_SIZE;
+
+        blocks[i].resize(size);
+        size_t length = compressBlock(source, size, blocks[i].data(), size - 1);
+        if(length)
+        {
+            blocks[i].resize(length);
+            lengths[i] = (uint32_t)length;
+        }
+        else
+        {
+            std::memcpy(blocks[i].data(), source, size);
+            lengths[i] = (uint32_t)size | RAW_BLOCK;
+        }
+        return true;
+    });
+
+    size_t total = HEADER_SIZE + count * sizeof(uint32_t);
+    for(const auto& block : blocks)
+    {
+        total += block.size();
+    }
+
+    std::vector<uint8_t> result(total);
+    uint8_t *out = result.data();
+    uint64_t size = data.size();
+
+    std::memcpy(out, MAGIC, sizeof(MAGIC));
+    std::memcpy(out + sizeof(MAGIC), &size, sizeof(size));
+    std::memcpy(out + sizeof(MAGIC) + sizeof(size), &count, sizeof(count));
+    out += HEADER_SIZE;
+    if(count)
+    {
+        std::memcpy(out, lengths.data(), count * sizeof(uint32_t));
+        out += count * sizeof(uint32_t);
+    }
+    for(const auto& block : blocks)
+    {
+        if(block.size())
+        {
+            std::memcpy(out, block.data(), block.size());
+            out += block.size();
+        }
+    }
+    return result;
+}
+
+bool compression::decompress(const std::vector<uint8_t>& data, std::vector<uint8_t>& result, size_t threads)
+{
+    if(!compressed(data))
+        return false;
+
+    uint64_t size;
+    uint32_t count;
+    std::memcpy(&size, data.data() + sizeof(MAGIC), sizeof(size));
+    std::memcpy(&count, data.data() + sizeof(MAGIC) + sizeof(size), sizeof(count));
+
+    if(size > (uint64_t)count * BLOCK_SIZE || (count && size <= (uint64_t)(count - 1) * BLOCK_SIZE) || count > (data.size() - HEADER_SIZE) / sizeof(uint32_t))
+        return false;
+
+    // every block's position in the frame, found up front so blocks can be decoded in any order
+    std::vector<size_t> offsets(count + 1);
+    offsets[0] = HEADER_SIZE + count * sizeof(uint32_t);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t length;
+        std::memcpy(&length, data.data() + HEADER_SIZE + i * sizeof(uint32_t), sizeof(length));
+        offsets[i + 1] = offsets[i] + (length & ~RAW_BLOCK);
+        if(offsets[i + 1] > data.size())
+            return false;
+    }
+
+    result.resize(size);
+    return forBlocks(count, threads, [&](size_t i)
+    {
+        uint32_t length;
+        std::memcpy(&length, data.data() + HEADER_SIZE + i * sizeof(uint32_t), sizeof(length));
+
+        size_t blockSize = std::min<size_t>(BLOCK_SIZE, size - i * BLOCK_SIZE);
+        const uint8_t *source = data.data() + offsets[i];
+        uint8_t *destination = result.data() + i * BLOCK_SIZE;
+
+        if(length & RAW_BLOCK)
+        {
+            if((length & ~RAW_BLOCK) != blockSize)
+                return false;
+            std::memcpy(destination, source, blockSize);
+            return true;
+        }
+        return decompressBlock(source, length, destination, blockSize);
+    });
+}
+
+Mesh file::loadObjFile(const std::string &fileName, bool compact)
 {
     std::vector<Vertex> vertices;
     int tri[3][3];
@@ -132,7 +535,11 @@ Mesh file::loadObjFile(const std::string &fileName)
     {
         std::cout << "ERROR :: " << fileName << " could not be opened." << std::endl;
     }
-    return Mesh(vertices, dimensions, average);
+
+    Mesh mesh(vertices, dimensions, average);
+    if(compact)
+        mesh.compact();
+    return mesh;
 }
 
 void loadImgsRecursive(const std::filesystem::path &directory, const std::string& append, Texture::Filter filter)
@@ -3,6 +3,11 @@
 
 #include "glad/glad.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
 uint32_t buffer::defaultType()
 {
     return GL_FRAMEBUFFER;
@@ -17,11 +22,11 @@ uint32_t buffer::drawType()
 }
 void buffer::enableDepthTest()
 {
-    glEnable(GL_DEPTH_TEST);
+    glstate::depthTest(true);
 }
 void buffer::disableDepthTest()
 {
-    glDisable(GL_DEPTH_TEST);
+    glstate::depthTest(false);
 }
 void buffer::blit(FrameBuffer& one, FrameBuffer& two, const Vector2& dim)
 {
@@ -32,6 +37,224 @@ void buffer::blit(FrameBuffer& one, FrameBuffer& two, const Vector2& dim)
     two.unbind(buffer::drawType());
 }
 
+void UniformBuffer::initialize(uint32_t binding__, size_t size__)
+{
+    binding = binding__;
+    size = size__;
+    glGenBuffers(1, &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, data);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, data);
+}
+void UniformBuffer::update(const void *value, size_t length, size_t offset)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, data);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, length, value);
+}
+void UniformBuffer::remove()
+{
+    if(data)
+        glDeleteBuffers(1, &data);
+    data = 0;
+}
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must follow the std140 layout of 'Camera'");
+static_assert(sizeof(LightBlock) == 96, "LightBlock must follow the std140 layout of 'Lights'");
+static_assert(sizeof(LightClusters::Light) == 64, "LightClusters::Light must span four RGBA32F texels");
+
+namespace
+{
+    // distance at which a light's attenuated strength drops below one 8-bit step :: lights without falloff reach 'limit'
+    float lightRange(const LightClusters::Light& light, float limit)
+    {
+        float strength = light.strength * std::max({light.color.r, light.color.g, light.color.b});
+        float constant = light.constant - 256 * strength;
+        if(constant >= 0)
+            return 0;
+        if(light.quadratic > 0)
+            return std::min((-light.linear + std::sqrt(light.linear * light.linear - 4 * light.quadratic * constant)) / (2 * light.quadratic), limit);
+        if(light.linear > 0)
+            return std::min(-constant / light.linear, limit);
+        return limit;
+    }
+}
+
+void LightClusters::initialize()
+{
+    const uint32_t formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+    glGenBuffers(3, buffers);
+    glGenTextures(3, textures);
+    for(uint32_t i=0; i<3; i++)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(Light), NULL, GL_STREAM_DRAW);
+        glstate::bindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+
+    for(uint32_t i=0; i<3; i++)
+    {
+        minimum[i].resize(COUNT);
+        maximum[i].resize(COUNT);
+    }
+    counts.resize(COUNT);
+    grid.resize(COUNT * 2);
+    changed = true;
+}
+void LightClusters::remove()
+{
+    if(buffers[0])
+    {
+        glDeleteBuffers(3, buffers);
+        glDeleteTextures(3, textures);
+        glstate::invalidate();
+    }
+    std::fill(buffers, buffers + 3, 0);
+    std::fill(textures, textures + 3, 0);
+}
+// the froxels are boxes in the camera basis (right, up, front) with exponential depth slices, the same space object_frag places fragments in
+void LightClusters::build(LightBlock& block, const Vector3& position, const Vector3& front, const Vector3& up, float fov, float aspect, float nearDistance, float farDistance)
+{
+    Vector3 forward = front.normalized();
+    Vector3 right = forward.cross(up).normalized();
+    Vector3 upward = right.cross(forward);
+    float tanY = std::tan(math::radians(fov) * 0.5f), tanX = tanY * aspect;
+    float depthScale = Z / std::log(farDistance / nearDistance);
+
+    block.front = forward;
+    block.right = right;
+    block.up = upward;
+    block.nearDistance = nearDistance;
+    block.tanX = tanX;
+    block.tanY = tanY;
+    block.depthScale = depthScale;
+
+    // fragments outside the grid are clamped into its outer tiles and slices, so those reach well past the frustum
+    const float edge = 1000;
+    for(uint32_t k=0; k<Z; k++)
+    {
+        float zNear = k == 0 ? 0 : nearDistance * std::pow(farDistance / nearDistance, (float)k / Z);
+        float zFar = k == Z - 1 ? farDistance * 2 : nearDistance * std::pow(farDistance / nearDistance, (float)(k + 1) / Z);
+        for(uint32_t j=0; j<Y; j++)
+        {
+            float y0 = j == 0 ? -edge * tanY : (-1 + 2.f * j / Y) * tanY;
+            float y1 = j == Y - 1 ? edge * tanY : (-1 + 2.f * (j + 1) / Y) * tanY;
+            for(uint32_t i=0; i<X; i++)
+            {
+                float x0 = i == 0 ? -edge * tanX : (-1 + 2.f * i / X) * tanX;
+                float x1 = i == X - 1 ? edge * tanX : (-1 + 2.f * (i + 1) / X) * tanX;
+
+                uint32_t index = (k * Y + j) * X + i;
+                minimum[0][index] = std::min(zNear * x0, zFar * x0);
+                maximum[0][index] = std::max(zNear * x1, zFar * x1);
+                minimum[1][index] = std::min(zNear * y0, zFar * y0);
+                maximum[1][index] = std::max(zNear * y1, zFar * y1);
+                minimum[2][index] = zNear;
+                maximum[2][index] = zFar;
+            }
+        }
+    }
+
+    auto slice = [&](float depth)
+    {
+        return depth <= nearDistance ? 0u : std::min<uint32_t>(std::log(depth / nearDistance) * depthScale, Z - 1);
+    };
+
+    size_t total = std::min<size_t>(points.size() + spots.size(), UINT16_MAX + 1);
+    hits.clear();
+    std::fill(counts.begin(), counts.end(), 0);
+
+    std::array<uint8_t, X * Y> overlap;
+    for(size_t index=0; index<total; index++)
+    {
+        const Light& light = index < points.size() ? points[index] : spots[index - points.size()];
+        float range = lightRange(light, farDistance * 2);
+        Vector3 relative = light.position - position;
+        float x = relative.dot(right), y = relative.dot(upward), z = relative.dot(forward);
+        if(range <= 0 || z + range < 0)
+            continue;
+
+        // spot lights are also tested as cones against each froxel's bounding sphere, unless they open wider than a hemisphere
+        bool cone = light.cutOff >= -1 && light.outerCutOff > 0;
+        Vector3 direction = light.direction.normalized();
+        Vector3 axis(direction.dot(right), direction.dot(upward), direction.dot(forward));
+        float cosine = light.outerCutOff, sine = std::sqrt(std::max(0.f, 1 - cosine * cosine));
+
+        for(uint32_t k=slice(z - range), last=slice(z + range); k<=last; k++)
+        {
+            const float *minX = minimum[0].data() + k * X * Y, *minY = minimum[1].data() + k * X * Y, *minZ = minimum[2].data() + k * X * Y;
+            const float *maxX = maximum[0].data() + k * X * Y, *maxY = maximum[1].data() + k * X * Y, *maxZ = maximum[2].data() + k * X * Y;
+
+            for(uint32_t c=0; c<X * Y; c++)
+            {
+                float dx = std::max(minX[c] - x, 0.f) + std::max(x - maxX[c], 0.f);
+                float dy = std::max(minY[c] - y, 0.f) + std::max(y - maxY[c], 0.f);
+                float dz = std::max(minZ[c] - z, 0.f) + std::max(z - maxZ[c], 0.f);
+                overlap[c] = dx * dx + dy * dy + dz * dz <= range * range;
+            }
+
+            if(cone)
+            {
+                for(uint32_t c=0; c<X * Y; c++)
+                {
+                    float hx = (maxX[c] - minX[c]) * 0.5f, hy = (maxY[c] - minY[c]) * 0.5f, hz = (maxZ[c] - minZ[c]) * 0.5f;
+                    float vx = minX[c] + hx - x, vy = minY[c] + hy - y, vz = minZ[c] + hz - z;
+                    float radius = std::sqrt(hx * hx + hy * hy + hz * hz);
+                    float distance2 = vx * vx + vy * vy + vz * vz;
+                    float along = vx * axis.x + vy * axis.y + vz * axis.z;
+                    float closest = cosine * std::sqrt(std::max(distance2 - along * along, 0.f)) - along * sine;
+                    overlap[c] &= closest <= radius && along <= radius + range && along >= -radius;
+                }
+            }
+
+            for(uint32_t c=0; c<X * Y; c++)
+            {
+                if(overlap[c])
+                {
+                    hits.push_back({k * X * Y + c, (uint16_t)index});
+                    counts[k * X * Y + c]++;
+                }
+            }
+        }
+    }
+
+    // hits arrive light by light, so scattering them by cluster keeps every cluster's list in light order
+    uint32_t offset = 0;
+    for(uint32_t c=0; c<COUNT; c++)
+    {
+        grid[c * 2] = offset;
+        grid[c * 2 + 1] = counts[c];
+        offset += counts[c];
+        counts[c] = grid[c * 2];
+    }
+    indices.resize(hits.size());
+    for(const auto& hit : hits)
+    {
+        indices[counts[hit.first]++] = hit.second;
+    }
+
+    size_t pointCount = std::min(points.size(), total);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers[0]);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(Light) * std::max<size_t>(total, 1), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, sizeof(Light) * pointCount, points.data());
+    glBufferSubData(GL_TEXTURE_BUFFER, sizeof(Light) * pointCount, sizeof(Light) * (total - pointCount), spots.data());
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers[1]);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(uint32_t) * grid.size(), grid.data(), GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers[2]);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(uint16_t) * std::max<size_t>(indices.size(), 1), indices.size() ? indices.data() : NULL, GL_STREAM_DRAW);
+}
+// binds light data, the cluster grid and the light indices to 'unit' and the two units after it
+void LightClusters::bind(uint32_t unit) const
+{
+    for(uint32_t i=0; i<3; i++)
+    {
+        glstate::bindTexture(unit + i, GL_TEXTURE_BUFFER, textures[i]);
+    }
+    glstate::activeTexture(0);
+}
+
 void FrameBuffer::initialize()
 {
     glGenFramebuffers(1, &data);
@@ -47,13 +270,14 @@ void FrameBuffer::remove()
         glDeleteTextures(1, &(texture.second.data));
     }
     glDeleteFramebuffers(1, &data);
+    glstate::invalidate();
 }
 void FrameBuffer::refresh(uint16_t width, uint16_t height, bool opaque)
 {
     bind(GL_FRAMEBUFFER);
     for(auto texture : textures)
     {
-        glBindTexture(texture.second.type, texture.second.data);
+        glstate::bindTexture(texture.second.type, texture.second.data);
         if(texture.second.type == GL_TEXTURE_2D_MULTISAMPLE)
         {
             texture.second.component = opaque ? GL_RGB : GL_RGBA;
@@ -79,7 +303,7 @@ void FrameBuffer::addTexture(const std::string& name, uint16_t width, uint16_t h
     bind(GL_FRAMEBUFFER);
 
     glGenTextures(1, &texture);
-    glBindTexture(type, texture);
+    glstate::bindTexture(type, texture);
     
     if(samples)
     {
@@ -116,15 +340,15 @@ void FrameBuffer::addRenderBuffer(const std::string& name, uint16_t width, uint1
 
 void FrameBuffer::bind(uint32_t type)
 {
-    glBindFramebuffer(type, data);
+    glstate::bindFramebuffer(type, data);
 }
 void FrameBuffer::unbind(uint32_t type)
 {
-    glBindFramebuffer(type, 0);  
+    glstate::bindFramebuffer(type, 0);  
 }
 void FrameBuffer::bindTexture(const std::string& name)
 {
-    glBindTexture(textures[name].type, textures[name].data);
+    glstate::bindTexture(textures[name].type, textures[name].data);
 }
 int FrameBuffer::complete()
 {
@@ -152,3 +376,104 @@ std::vector<uint8_t> FrameBuffer::getTextureData(const std::string& name)
     return result;
 }
 
+// least significant byte first :: passes where every key shares the byte are skipped, which is most of them for a typical frame
+static void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order, std::vector<uint64_t>& scratchKeys, std::vector<uint32_t>& scratch)
+{
+    size_t count = keys.size();
+    std::array<std::array<uint32_t, 256>, 8> histograms = {};
+    for(uint64_t key : keys)
+    {
+        for(uint32_t digit = 0; digit < 8; digit++)
+            histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+    }
+
+    scratchKeys.resize(count);
+    scratch.resize(count);
+    for(uint32_t digit = 0; digit < 8; digit++)
+    {
+        std::array<uint32_t, 256>& histogram = histograms[digit];
+        uint32_t shift = digit * 8;
+        if(histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t sum = 0;
+        for(uint32_t& bucket : histogram)
+        {
+            uint32_t amount = bucket;
+            bucket = sum;
+            sum += amount;
+        }
+        for(size_t i=0; i<count; i++)
+        {
+            uint32_t& slot = histogram[(keys[i] >> shift) & 0xFF];
+            scratchKeys[slot] = keys[i];
+            scratch[slot] = order[i];
+            slot++;
+        }
+        keys.swap(scratchKeys);
+        order.swap(scratch);
+    }
+}
+
+void RenderQueue::add(const Shader& shader, const Model& model, const Instance& instance, float depth, bool translucent, uint8_t layer)
+{
+    uint8_t slot = std::find(programs.begin(), programs.end(), shader.ID) - programs.begin();
+    if(slot == programs.size())
+        programs.push_back(shader.ID);
+
+    keys.push_back(key(layer, translucent, slot, model.texture.texture, model.data.id, depth));
+    packets.push_back({shader.ID, model.texture.texture, model.data});
+    instances.push_back(instance);
+    model.mesh().place(instances.back());
+}
+void RenderQueue::submit()
+{
+    if(!packets.size())
+        return;
+    if(!buffer)
+        glGenBuffers(1, &buffer);
+
+    order.resize(packets.size());
+    std::iota(order.begin(), order.end(), 0);
+    radixSort(keys, order, scratchKeys, scratch);
+
+    sorted.resize(instances.size());
+    for(size_t i=0; i<order.size(); i++)
+        sorted[i] = instances[order[i]];
+
+    // the whole frame is uploaded once :: each run then points its instance attributes at its own range
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, sorted.size() * sizeof(Instance), sorted.data(), GL_STREAM_DRAW);
+    bool translucent = false;
+    for(size_t first = 0, last = 0; first < order.size(); first = last)
+    {
+        const DrawPacket& packet = packets[order[first]];
+        uint64_t pass = keys[first] >> 59;
+        for(last = first + 1; last < order.size(); last++)
+        {
+            const DrawPacket& next = packets[order[last]];
+            if(keys[last] >> 59 != pass || next.shader != packet.shader || next.texture != packet.texture || next.mesh != packet.mesh)
+                break;
+        }
+
+        // the state cache drops every bind that matches the previous run
+        translucent = pass & 1;
+        glstate::depthMask(!translucent);
+        glstate::useProgram(packet.shader);
+        glstate::bindTexture(0, GL_TEXTURE_2D, packet.texture);
+        Mesh::get(packet.mesh).drawInstanced(buffer, first, last - first);
+    }
+    if(translucent)
+        glstate::depthMask(true);
+
+    programs.clear();
+    keys.clear();
+    packets.clear();
+    instances.clear();
+}
+void RenderQueue::remove()
+{
+    if(buffer)
+        glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
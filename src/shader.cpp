@@ -4,10 +4,309 @@
 #include "glad/glad.h"
 #include "image/stb_image.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <unordered_map>
 
+namespace
+{
+    // UniformValue (struct): the last bytes uploaded to one uniform location :: matrices are the largest at 16 floats
+    struct UniformValue
+    {
+        uint32_t size = 0;
+        std::array<float, 16> data;
+    };
+
+    // GLState (struct): the state the engine last handed to GL :: -1 marks state that is unknown and always issued
+    struct GLState
+    {
+        uint32_t program = -1, vertexArray = -1, readFramebuffer = -1, drawFramebuffer = -1, unit = -1;
+        int32_t depthMask = -1, depthTest = -1;
+        std::unordered_map<uint64_t, uint32_t> textures;
+        std::unordered_map<uint32_t, std::vector<UniformValue>> uniforms;
+        glstate::Counters counters;
+    };
+    GLState cache;
+
+    // identical vertices compare equal byte for byte, so -0 and 0 stay distinct
+    struct VertexHash
+    {
+        size_t operator()(const Vertex& vertex) const
+        {
+            uint32_t words[sizeof(Vertex) / 4];
+            std::memcpy(words, &vertex, sizeof(Vertex));
+            size_t value = 14695981039346656037ull;
+            for(uint32_t word : words)
+                value = (value ^ word) * 1099511628211ull;
+            return value;
+        }
+    };
+    struct VertexEqual
+    {
+        bool operator()(const Vertex& one, const Vertex& two) const
+        {
+            return !std::memcmp(&one, &two, sizeof(Vertex));
+        }
+    };
+
+    // rounds to the nearest half float, ties to even
+    uint16_t toHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = (bits >> 16) & 0x8000;
+        int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if(((bits >> 23) & 0xFF) == 0xFF)
+            return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+        if(exponent < -10)
+            return sign;
+
+        // values below the normal range become subnormals, which drop the implicit leading one
+        uint32_t shift = 13;
+        if(exponent <= 0)
+        {
+            mantissa |= 0x800000;
+            shift = 14 - exponent;
+            exponent = 0;
+        }
+
+        uint32_t half = ((uint32_t)exponent << 10) + (mantissa >> shift);
+        uint32_t rest = mantissa & ((1u << shift) - 1), middle = 1u << (shift - 1);
+        if(rest > middle || (rest == middle && (half & 1)))
+            half++;   // a carry out of the mantissa correctly moves on to the next exponent
+        return sign | std::min<uint32_t>(half, 0x7C00);
+    }
+
+    // packs a unit vector into GL_INT_2_10_10_10_REV, x in the lowest bits
+    uint32_t toSigned1010102(const Vector3& normal)
+    {
+        auto component = [](float value)
+        {
+            return (uint32_t)(int32_t)std::round(std::clamp(value, -1.f, 1.f) * 511) & 0x3FF;
+        };
+        return component(normal.x) | component(normal.y) << 10 | component(normal.z) << 20;
+    }
+
+    // vertex attributes of the two GeometryPool layouts, read from the bound vertex buffer
+    void fullLayout()
+    {
+        // vertex positions
+        glEnableVertexAttribArray(0);	
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);	
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Vector3));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);	
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Vector3)*2));
+    }
+    void compactLayout()
+    {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, uv));
+    }
+
+    // Tipsify (Sander, Nehab and Barczak, 2007) :: fans around the most recently used vertex that will still be in a cache of 'cacheSize' entries
+    std::vector<uint32_t> tipsify(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        uint32_t triangleCount = indices.size() / 3;
+
+        // triangles using each vertex, stored as one flat list with per-vertex offsets
+        std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(indices.size());
+        for(uint32_t index : indices)
+            live[index]++;
+        for(uint32_t v=0; v<vertexCount; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for(uint32_t i=0; i<indices.size(); i++)
+            adjacency[fill[indices[i]]++] = i / 3;
+
+        std::vector<uint32_t> stamps(vertexCount, 0), deadEnd, candidates, result;
+        std::vector<bool> emitted(triangleCount, false);
+        result.reserve(indices.size());
+
+        int64_t fanning = vertexCount ? 0 : -1;
+        uint32_t time = cacheSize + 1, cursor = 0;
+        while(fanning >= 0)
+        {
+            candidates.clear();
+            for(uint32_t a=offsets[fanning]; a<offsets[fanning + 1]; a++)
+            {
+                uint32_t triangle = adjacency[a];
+                if(emitted[triangle])
+                    continue;
+
+                for(uint32_t k=0; k<3; k++)
+                {
+                    uint32_t v = indices[triangle * 3 + k];
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if(time - stamps[v] > cacheSize)
+                        stamps[v] = time++;
+                }
+                emitted[triangle] = true;
+            }
+
+            // prefers the candidate that stays cached longest while its remaining triangles are emitted
+            fanning = -1;
+            int64_t best = -1;
+            for(uint32_t v : candidates)
+            {
+                if(!live[v])
+                    continue;
+                int64_t priority = time - stamps[v] + 2 * live[v] <= cacheSize ? time - stamps[v] : 0;
+                if(priority > best)
+                {
+                    best = priority;
+                    fanning = v;
+                }
+            }
+
+            // dead end :: falls back to recently emitted vertices, then to the next vertex in input order
+            while(fanning < 0 && deadEnd.size())
+            {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if(live[v])
+                    fanning = v;
+            }
+            while(fanning < 0 && cursor < vertexCount)
+            {
+                if(live[cursor])
+                    fanning = cursor;
+                cursor++;
+            }
+        }
+        return result;
+    }
+
+    // counts the call and returns whether it has to reach GL
+    bool changed(uint32_t& current, uint32_t value)
+    {
+        if(current == value)
+        {
+            cache.counters.elided++;
+            return false;
+        }
+        current = value;
+        cache.counters.issued++;
+        return true;
+    }
+}
+
+void glstate::useProgram(uint32_t program)
+{
+    if(changed(cache.program, program))
+        glUseProgram(program);
+}
+void glstate::bindVertexArray(uint32_t array)
+{
+    if(changed(cache.vertexArray, array))
+        glBindVertexArray(array);
+}
+void glstate::bindTexture(uint32_t type, uint32_t texture)
+{
+    bindTexture(cache.unit == -1 ? 0 : cache.unit, type, texture);
+}
+void glstate::bindTexture(uint32_t unit, uint32_t type, uint32_t texture)
+{
+    auto found = cache.textures.find(((uint64_t)unit << 32) | type);
+    if(found != cache.textures.end() && found->second == texture)
+    {
+        cache.counters.elided++;
+        return;
+    }
+
+    if(changed(cache.unit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+    cache.textures[((uint64_t)unit << 32) | type] = texture;
+    cache.counters.issued++;
+    glBindTexture(type, texture);
+}
+void glstate::activeTexture(uint32_t unit)
+{
+    if(changed(cache.unit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+void glstate::bindFramebuffer(uint32_t target, uint32_t framebuffer)
+{
+    bool read = target != GL_DRAW_FRAMEBUFFER, draw = target != GL_READ_FRAMEBUFFER;
+    if((!read || cache.readFramebuffer == framebuffer) && (!draw || cache.drawFramebuffer == framebuffer))
+    {
+        cache.counters.elided++;
+        return;
+    }
+
+    if(read)
+        cache.readFramebuffer = framebuffer;
+    if(draw)
+        cache.drawFramebuffer = framebuffer;
+    cache.counters.issued++;
+    glBindFramebuffer(target, framebuffer);
+}
+void glstate::depthMask(bool enabled)
+{
+    if(changed((uint32_t&)cache.depthMask, enabled))
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+void glstate::depthTest(bool enabled)
+{
+    if(!changed((uint32_t&)cache.depthTest, enabled))
+        return;
+    if(enabled)
+        glEnable(GL_DEPTH_TEST);
+    else
+        glDisable(GL_DEPTH_TEST);
+}
+bool glstate::uniform(int location, const void *value, uint32_t size)
+{
+    // GL ignores location -1, so there is nothing to upload
+    if(location < 0 || cache.program == -1)
+    {
+        cache.counters.elided += location < 0;
+        return location >= 0;
+    }
+
+    std::vector<UniformValue>& values = cache.uniforms[cache.program];
+    // 'location' is known to be non-negative here
+    if((size_t)location >= values.size())
+        values.resize(location + 1);
+
+    UniformValue& last = values[location];
+    if(last.size == size && !std::memcmp(last.data.data(), value, size))
+    {
+        cache.counters.elided++;
+        return false;
+    }
+    last.size = size;
+    std::memcpy(last.data.data(), value, size);
+    cache.counters.issued++;
+    return true;
+}
+void glstate::invalidate()
+{
+    glstate::Counters counters = cache.counters;
+    cache = GLState();
+    cache.counters = counters;
+}
+glstate::Counters& glstate::counters()
+{
+    return cache.counters;
+}
+
 
 Shader::Shader(std::string vertexPath, std::string fragmentPath)
 {
@@ -41,96 +340,163 @@ Shader::Shader(std::string vertexPath, std::string fragmentPath)
     }
 
     glLinkProgram(ID);
+    reflect();
 }
 void Shader::use() const
 {
-    glUseProgram(ID);
+    glstate::useProgram(ID);
 }
 void Shader::remove() const
 {
+    std::erase_if(locations, [this](const auto& pair){return pair.first >> 32 == ID;});
     glDeleteProgram(ID);
+    glstate::invalidate();
 }
 void Shader::setUniforms(const std::vector<std::string>& names, std::vector<int *>& results) const
 {
     for(int i=0; i<names.size(); i++)
     {
-        *results[i] = glGetUniformLocation(ID, names[i].c_str());
+        *results[i] = find(UniformId::of(names[i]));
     }
 }
+// records every active uniform once, so setters never have to ask GL for a location :: arrays are recorded by their base name and by each element
+void Shader::reflect() const
+{
+    int32_t linked = 0, count = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if(!linked)
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        std::cout << "ERROR :: Shader linking failed: " << infoLog << std::endl;
+        return;
+    }
 
-void Shader::setBool(const std::string &name, bool value) const
-{         
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    auto add = [this](const std::string& name, int32_t location)
+    {
+        auto result = locations.insert({(uint64_t)ID << 32 | UniformId::of(name), location});
+        if(!result.second && result.first->second != location)
+            std::cout << "ERROR :: Uniform '" << name << "' shares its hash with another uniform of the same shader." << std::endl;
+    };
+
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    for(int32_t i=0; i<count; i++)
+    {
+        char buffer[256];
+        int32_t length = 0, size = 0;
+        uint32_t type = 0;
+        glGetActiveUniform(ID, i, sizeof(buffer), &length, &size, &type, buffer);
+
+        std::string name(buffer, length);
+        int32_t location = glGetUniformLocation(ID, name.c_str());
+        if(location < 0)
+            continue;   // members of uniform blocks have no location
+
+        add(name, location);
+        if(name.ends_with("[0]"))
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            add(base, location);
+            for(int32_t element=1; element<size; element++)
+            {
+                std::string indexed = base + "[" + std::to_string(element) + "]";
+                add(indexed, glGetUniformLocation(ID, indexed.c_str()));
+            }
+        }
+    }
 }
-void Shader::setInt(const std::string &name, int32_t value) const
-{ 
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    glUniform1i(transformLoc, value); 
+int Shader::find(uint32_t hash) const
+{
+    auto found = locations.find((uint64_t)ID << 32 | hash);
+    return found == locations.end() ? -1 : found->second;
 }
-void Shader::setFloat(const std::string &name, float value) const
+int Shader::location(UniformId id) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    glUniform1f(transformLoc, value); 
-} 
-void Shader::setVec2(const std::string &name, const Vector2 &vec2) const
+    return find(id.hash);
+}
+
+void Shader::setBool(UniformId id, bool value) const
+{
+    setBool(find(id.hash), value);
+}
+void Shader::setInt(UniformId id, int32_t value) const
+{
+    setInt(find(id.hash), value);
+}
+void Shader::setFloat(UniformId id, float value) const
+{
+    setFloat(find(id.hash), value);
+}
+void Shader::setVec2(UniformId id, const Vector2 &vec2) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    // if(transformLoc == -1) std::cout << ID << " :: " << name << " = " << vec2 << std::endl;
-    glUniform2f(transformLoc, vec2.x, vec2.y);
+    setVec2(find(id.hash), vec2);
 }
-void Shader::setVec3(const std::string &name, const Vector3 &vec3) const
+void Shader::setVec3(UniformId id, const Vector3 &vec3) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    // if(transformLoc == -1) std::cout << ID << " :: " << name << " = " << vec3 << std::endl;
-    glUniform3f(transformLoc, vec3.x, vec3.y, vec3.z);
+    setVec3(find(id.hash), vec3);
 }
-void Shader::setColor3(const std::string &name, const Color &vec3) const
+void Shader::setColor3(UniformId id, const Color &vec3) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    glUniform3f(transformLoc, vec3.r, vec3.g, vec3.b);
+    setColor3(find(id.hash), vec3);
 }
-void Shader::setVec4(const std::string &name, const Color &vec4) const
+void Shader::setVec4(UniformId id, const Color &vec4) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    glUniform4f(transformLoc, vec4.r, vec4.g, vec4.b, vec4.a);
+    setVec4(find(id.hash), vec4);
 }
-void Shader::setMat4(const std::string &name, const float *transform, bool transpose) const
+void Shader::setMat4(UniformId id, const float *transform, bool transpose) const
 {
-    int transformLoc = glGetUniformLocation(ID, name.c_str());
-    glUniformMatrix4fv(transformLoc, 1, transpose, transform);
+    setMat4(find(id.hash), transform, transpose);
 }
 
+// each setter only reaches GL when the value differs from the one the current program already holds
 void Shader::setBool(int loc, bool value) const
 {         
-    glUniform1i(loc, (int)value); 
+    int32_t data = value;
+    if(glstate::uniform(loc, &data, sizeof(data)))
+        glUniform1i(loc, data); 
 }
 void Shader::setInt(int loc, int32_t value) const
 { 
-    glUniform1i(loc, value); 
+    if(glstate::uniform(loc, &value, sizeof(value)))
+        glUniform1i(loc, value); 
 }
 void Shader::setFloat(int loc, float value) const
 {
-    glUniform1f(loc, value); 
+    if(glstate::uniform(loc, &value, sizeof(value)))
+        glUniform1f(loc, value); 
 } 
 void Shader::setVec2(int loc, const Vector2 &vec2) const
 {
-    glUniform2f(loc, vec2.x, vec2.y);
+    float data[2] = {vec2.x, vec2.y};
+    if(glstate::uniform(loc, data, sizeof(data)))
+        glUniform2f(loc, vec2.x, vec2.y);
 }
 void Shader::setVec3(int loc, const Vector3 &vec3) const
 {
-    glUniform3f(loc, vec3.x, vec3.y, vec3.z);
+    float data[3] = {vec3.x, vec3.y, vec3.z};
+    if(glstate::uniform(loc, data, sizeof(data)))
+        glUniform3f(loc, vec3.x, vec3.y, vec3.z);
 }
 void Shader::setColor3(int loc, const Color &vec3) const
 {
-    glUniform3f(loc, vec3.r, vec3.g, vec3.b);
+    float data[3] = {vec3.r, vec3.g, vec3.b};
+    if(glstate::uniform(loc, data, sizeof(data)))
+        glUniform3f(loc, vec3.r, vec3.g, vec3.b);
 }
 void Shader::setVec4(int loc, const Color &vec4) const
 {
-    glUniform4f(loc, vec4.r, vec4.g, vec4.b, vec4.a);
+    float data[4] = {vec4.r, vec4.g, vec4.b, vec4.a};
+    if(glstate::uniform(loc, data, sizeof(data)))
+        glUniform4f(loc, vec4.r, vec4.g, vec4.b, vec4.a);
 }
 void Shader::setMat4(int loc, const float *transform, bool transpose) const
 {
-    glUniformMatrix4fv(loc, 1, transpose, transform);
+    // the transpose flag changes the uploaded value, so it is stored with the matrix
+    float data[16];
+    for(int i=0; i<16; i++)
+        data[i] = transpose ? transform[(i % 4) * 4 + i / 4] : transform[i];
+    if(glstate::uniform(loc, data, sizeof(data)))
+        glUniformMatrix4fv(loc, 1, GL_FALSE, data);
 }
 
 uint32_t Shader::compileShader(const std::string &contents, uint32_t type) const
@@ -157,10 +523,13 @@ uint32_t Shader::compileShader(const std::string &contents, uint32_t type) const
 
 void Shader::load(const std::string& path, const Shader& shader)
 {
+    std::unique_lock<std::shared_mutex> guard(registry);
     loadedShaders[path] = shader;
 }
 Shader &Shader::get(const std::string& path)
 {
+    // references into the map stay valid when other shaders are added
+    std::shared_lock<std::shared_mutex> guard(registry);
     if(!loadedShaders.count(path))
     {
         std::cout << "ERROR :: Shader at \'" << path << "\' could not be found." << std::endl;
@@ -168,29 +537,177 @@ Shader &Shader::get(const std::string& path)
     }
     return loadedShaders.at(path);
 }
+void Shader::bindBlock(const std::string& name, uint32_t binding)
+{
+    std::shared_lock<std::shared_mutex> guard(registry);
+    for(auto& pair : loadedShaders)
+    {
+        uint32_t index = glGetUniformBlockIndex(pair.second.ID, name.c_str());
+        if(index != GL_INVALID_INDEX)
+            glUniformBlockBinding(pair.second.ID, index, binding);
+    }
+}
 void Shader::clear()
 {
+    std::unique_lock<std::shared_mutex> guard(registry);
     for (auto &pair : loadedShaders)
     {
         pair.second.remove();
     }
 }
 
+void GeometryPool::initialize(uint32_t vertexSize, void (*layout__)())
+{
+    layout = layout__;
+    arenas[0].elementSize = vertexSize;
+    arenas[1].elementSize = sizeof(uint32_t);
+    glGenVertexArrays(1, &VAO);
+    grow(false, 1 << 16);
+    grow(true, 3 << 16);
+}
+void GeometryPool::remove()
+{
+    if(VAO)
+        glDeleteVertexArrays(1, &VAO);
+    for(Arena& arena : arenas)
+    {
+        if(arena.buffer)
+            glDeleteBuffers(1, &arena.buffer);
+        arena.buffer = 0;
+        arena.capacity = 0;
+        arena.blocks.clear();
+    }
+    VAO = 0;
+    glstate::invalidate();
+}
+// first fit over the free blocks :: a pool that is out of room at least doubles
+GeometryPool::Range GeometryPool::allocate(bool index, uint32_t count)
+{
+    if(!count)
+        return Range();
+
+    Arena& arena = arenas[index];
+    for(auto block = arena.blocks.begin(); block != arena.blocks.end(); block++)
+    {
+        if(block->second < count)
+            continue;
+
+        Range range{block->first, count};
+        if(block->second > count)
+            arena.blocks[block->first + count] = block->second - count;
+        arena.blocks.erase(block);
+        return range;
+    }
+
+    grow(index, std::max(arena.capacity, count));
+    return allocate(index, count);
+}
+// uploads go through the copy target, so whichever Vertex Array Object is bound keeps its index buffer
+void GeometryPool::write(bool index, Range range, const void *data)
+{
+    if(!range.count)
+        return;
+
+    Arena& arena = arenas[index];
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range.first * arena.elementSize, (size_t)range.count * arena.elementSize, data);
+}
+// returned blocks merge with the free blocks on either side
+void GeometryPool::free(bool index, Range range)
+{
+    if(!range.count)
+        return;
+
+    std::map<uint32_t, uint32_t>& blocks = arenas[index].blocks;
+    auto next = blocks.lower_bound(range.first);
+    if(next != blocks.end() && range.first + range.count == next->first)
+    {
+        range.count += next->second;
+        next = blocks.erase(next);
+    }
+    if(next != blocks.begin())
+    {
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == range.first)
+        {
+            previous->second += range.count;
+            return;
+        }
+    }
+    blocks[range.first] = range.count;
+}
+// moves the arena into a buffer 'count' elements larger and points the Vertex Array Object at it
+void GeometryPool::grow(bool index, uint32_t count)
+{
+    Arena& arena = arenas[index];
+    uint32_t buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, (size_t)(arena.capacity + count) * arena.elementSize, NULL, GL_STATIC_DRAW);
+    if(arena.buffer)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, arena.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)arena.capacity * arena.elementSize);
+        glDeleteBuffers(1, &arena.buffer);
+        glstate::invalidate();
+    }
+    arena.buffer = buffer;
+    free(index, {arena.capacity, count});
+    arena.capacity += count;
+
+    glstate::bindVertexArray(VAO);
+    if(index)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        layout();
+    }
+}
+
 void Mesh::draw(const uint32_t texture) const
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    if(compacted)
+    {
+        std::cout << "ERROR :: Mesh " << id << " is compacted and can only be drawn through the RenderQueue." << std::endl;
+        return;
+    }
+    if(!allocation)
+        return;
+    glstate::bindTexture(0, GL_TEXTURE_2D, texture);
 
     // glActiveTexture(GL_TEXTURE2);
     // glBindTexture(GL_TEXTURE_2D, g_windows[currentWindow].screen.depthBuffer.getTexture("texture").data);
     
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+    glstate::bindVertexArray(pool().VAO);
+    glDrawElementsBaseVertex(GL_TRIANGLES, allocation->indices.count, GL_UNSIGNED_INT, (void*)(allocation->indices.first * sizeof(uint32_t)), allocation->vertices.first);
+}
+void Mesh::drawInstanced(const uint32_t instances, size_t first, uint32_t amount) const
+{
+    if(!allocation)
+        return;
+    glstate::bindVertexArray(pool().VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instances);
+
+    // instance attributes start after the mesh's own :: 4 matrix rows, then color, scale, uv, and material as vec4s
+    static_assert(sizeof(Instance) == 8 * 4 * sizeof(float), "Instance must pack into 8 vec4 attributes");
+    size_t base = first * sizeof(Instance);
+    for(uint32_t i=0; i<8; i++)
+    {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + i * 4 * sizeof(float)));
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, allocation->indices.count, GL_UNSIGNED_INT, (void*)(allocation->indices.first * sizeof(uint32_t)), amount, allocation->vertices.first);
 }
 void Mesh::reinit(const std::vector<Vector3>& vertices__, const std::vector<float>& texture__, const Vector3& dimensions__)
 {
     dimensions = dimensions__;
     vertices.clear();
+    indices.clear();
+    uploaded = false;
     if(!vertices__.size() || !texture__.size())
         return;
 
@@ -202,46 +719,147 @@ void Mesh::reinit(const std::vector<Vector3>& vertices__, const std::vector<floa
             vertices.push_back({vertices__[i+j], normal, Vector2(texture__[(2*(i+j)) % texture__.size()], texture__[(2*(i+j)+1) % texture__.size()])});
         }
     }
+    index();
 }
 void Mesh::generate()
 {
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-    glGenBuffers(1, &VBO);
+    id = nextId++;
+    allocation.reset();
+    uploaded = false;
+}
+// vertices arrive as a plain triangle list until indexed, so each new index refers to the next vertex
+void Mesh::index()
+{
+    if(indices.size() || !vertices.size())
+        return;
+
+    uploaded = false;
+    std::vector<uint32_t> list(vertices.size());
+    std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+
+    std::vector<Vertex> merged;
+    for(size_t i=0; i<vertices.size(); i++)
+    {
+        auto inserted = unique.insert({vertices[i], (uint32_t)merged.size()});
+        if(inserted.second)
+            merged.push_back(vertices[i]);
+        list[i] = inserted.first->second;
+    }
+    list.resize(list.size() - list.size() % 3);
+
+    indices = tipsify(list, merged.size(), 16);
+
+    // vertices are renumbered in the order the triangles first use them, so fetches walk the buffer forwards
+    constexpr uint32_t UNMAPPED = UINT32_MAX;
+    std::vector<uint32_t> remap(merged.size(), UNMAPPED);
+    vertices.clear();
+    for(uint32_t& index : indices)
+    {
+        if(remap[index] == UNMAPPED)
+        {
+            remap[index] = vertices.size();
+            vertices.push_back(merged[index]);
+        }
+        index = remap[index];
+    }
+}
+void Mesh::compact()
+{
+    // ranges belong to the pool of the layout they were uploaded in
+    if(!compacted)
+        remove();
+    compacted = true;
+    uploaded = false;
+    packed.clear();
+    if(!vertices.size())
+        return;
+
+    Vector3 high = vertices[0].position;
+    boundsMin = vertices[0].position;
+    for(const Vertex& vertex : vertices)
+    {
+        boundsMin = vec3::min(boundsMin, vertex.position);
+        high = vec3::max(high, vertex.position);
+    }
+    boundsSize = high - boundsMin;
+
+    auto quantize = [](float value, float low, float size)
+    {
+        return (uint16_t)(size > 0 ? std::round((value - low) / size * 65535) : 0);
+    };
+    packed.reserve(vertices.size());
+    for(const Vertex& vertex : vertices)
+    {
+        CompactVertex result;
+        result.position[0] = quantize(vertex.position.x, boundsMin.x, boundsSize.x);
+        result.position[1] = quantize(vertex.position.y, boundsMin.y, boundsSize.y);
+        result.position[2] = quantize(vertex.position.z, boundsMin.z, boundsSize.z);
+        result.position[3] = 0;
+        result.normal = toSigned1010102(vertex.normal);
+        result.uv[0] = toHalf(vertex.uv.x);
+        result.uv[1] = toHalf(vertex.uv.y);
+        packed.push_back(result);
+    }
+}
+// the shader reads model * (position * scale), so a position stored as min + quantized * size becomes a scale by size and a shift by the rotated min
+void Mesh::place(Instance& instance) const
+{
+    if(!compacted)
+        return;
+
+    Vector3 shift = boundsMin * instance.scale;
+    float *matrix = instance.model.matrix;
+    for(int row=0; row<3; row++)
+        matrix[row * 4 + 3] += matrix[row * 4] * shift.x + matrix[row * 4 + 1] * shift.y + matrix[row * 4 + 2] * shift.z;
+    instance.scale = instance.scale * boundsSize;
 }
 void Mesh::refresh()
 {
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW); 
+    index();
+    if(uploaded || !indices.size())
+        return;
+    if(compacted && packed.size() != vertices.size())
+        compact();
+
+    // the mesh may have changed size, so its old ranges are returned before new ones are taken :: ranges still shared with copies stay theirs
+    remove();
+    GeometryPool& geometry = pool();
+    allocation = std::make_shared<Allocation>();
+    allocation->vertices = geometry.allocate(false, vertices.size());
+    allocation->indices = geometry.allocate(true, indices.size());
 
-    // vertex positions
-    glEnableVertexAttribArray(0);	
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // vertex normals
-    glEnableVertexAttribArray(1);	
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(Vector3));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);	
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(sizeof(Vector3)*2));
+    geometry.write(false, allocation->vertices, compacted ? (const void*)packed.data() : (const void*)vertices.data());
+    geometry.write(true, allocation->indices, indices.data());
+    uploaded = true;
 }
 void Mesh::remove()
 {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    if(allocation && allocation.use_count() == 1)
+    {
+        pool().free(false, allocation->vertices);
+        pool().free(true, allocation->indices);
+    }
+    allocation.reset();
+    uploaded = false;
+}
+GeometryPool& Mesh::pool() const
+{
+    GeometryPool& result = pools[compacted];
+    if(!result.VAO)
+        result.initialize(compacted ? sizeof(CompactVertex) : sizeof(Vertex), compacted ? compactLayout : fullLayout);
+    return result;
 }
 
-Mesh &Mesh::load(const std::string &path)
+Mesh &Mesh::load(const std::string &path, bool compact)
 {
-    loadedMeshes[path] = file::loadObjFile(path);
-    loadedMeshes[path].generate();
-    return(loadedMeshes[path]);
+    return load(path, file::loadObjFile(path, compact));
 }
 Mesh &Mesh::load(const std::string& path, const Mesh& mesh)
 {
-    loadedMeshes[path] = mesh;
-    loadedMeshes[path].generate();
-    return(loadedMeshes[path]);
+    Mesh& result = get(set(path, mesh));
+    result.generate();
+    return result;
 }
 void Mesh::load(const std::string &path, const std::vector<std::string> &subPaths, const std::string &type)
 {
@@ -250,38 +868,80 @@ void Mesh::load(const std::string &path, const std::vector<std::string> &subPath
         load(path + subPath + "." + type);
     }
 }
-void Mesh::set(const std::string& path, const Mesh& mesh)
+MeshHandle Mesh::set(const std::string& path, const Mesh& mesh)
 {
-    loadedMeshes[path] = mesh;
+    std::unique_lock<std::shared_mutex> guard(registry);
+    auto found = meshIds.find(path);
+    if(found != meshIds.end())
+    {
+        Mesh& replaced = loadedMeshes[found->second];
+        if(replaced.id != mesh.id)
+            replaced.remove();
+        loadedMeshes[found->second] = mesh;
+        return {found->second};
+    }
+
+    meshIds[path] = loadedMeshes.size();
+    meshPaths.push_back(path);
+    loadedMeshes.push_back(mesh);
+    return {(uint32_t)loadedMeshes.size() - 1};
 }
 Mesh &Mesh::get(const std::string &path)
 {
-    if(!loadedMeshes.count(path))
+    return get(handle(path));
+}
+Mesh &Mesh::get(MeshHandle handle)
+{
+    static Mesh empty;
+    if(handle.id >= loadedMeshes.size())
     {
-        std::cout << "ERROR :: Mesh at \'" << path << "\' could not be found." << std::endl;
-        return get("square");
+        if(handle.id != MeshHandle::NONE)
+            std::cout << "ERROR :: Mesh handle \'" << handle.id << "\' could not be found." << std::endl;
+        return empty;
     }
-    return loadedMeshes.at(path);
+    return loadedMeshes[handle.id];
 }
 std::vector<Mesh> Mesh::get(const std::string &path, const std::vector<std::string> &subPaths, const std::string &type)
 {
     std::vector<Mesh> meshes;
     for (std::string subPath : subPaths)
     {
-        meshes.push_back(loadedMeshes[path + subPath + "." + type]);
+        meshes.push_back(get(path + subPath + "." + type));
     }
     return meshes;
 }
+MeshHandle Mesh::handle(const std::string &path)
+{
+    {
+        std::shared_lock<std::shared_mutex> guard(registry);
+        auto found = meshIds.find(path);
+        if(found != meshIds.end())
+            return {found->second};
+    }
+
+    std::cout << "ERROR :: Mesh at \'" << path << "\' could not be found." << std::endl;
+    return path == "square" ? MeshHandle() : handle("square");
+}
+std::string Mesh::path(MeshHandle handle)
+{
+    std::shared_lock<std::shared_mutex> guard(registry);
+    return handle.id < meshPaths.size() ? meshPaths[handle.id] : std::string();
+}
 void Mesh::clear()
 {
-    for (auto &pair : loadedMeshes)
+    for (auto &mesh : loadedMeshes)
     {
-        pair.second.remove();
+        mesh.remove();
+    }
+    for (auto &pool : pools)
+    {
+        pool.remove();
     }
 }
 bool Mesh::contains(const std::string& path)
 {
-    return loadedMeshes.count(path);
+    std::shared_lock<std::shared_mutex> guard(registry);
+    return meshIds.count(path);
 }
 
 Mesh shape::sphere(float radius, int32_t lod)
@@ -537,9 +1197,23 @@ uint32_t Texture::filterToModifier(Filter filter)
 }
 
 void Texture::load(const std::string &path, Type type, Filter filter)
+{
+    upload(path, decode(path), type, filter);
+}
+Texture::Image Texture::decode(const std::string &path)
+{
+    Image image;
+    unsigned char *data = stbi_load((Source::root() + Source::texture() + path).c_str(), &image.width, &image.height, &image.channels, 0);
+    if (data)
+    {
+        image.pixels.assign(data, data + (size_t)image.width * image.height * image.channels);
+    }
+    stbi_image_free(data);
+    return image;
+}
+void Texture::upload(const std::string &path, const Image& image, Type type, Filter filter)
 {
     int32_t screenChannel = typeToModifier(type);
-    std::string screenChannelString = typeToString(type);
 
     uint32_t filterChannel = filterToModifier(filter);
     uint32_t minFilter = -1;
@@ -553,11 +1227,8 @@ void Texture::load(const std::string &path, Type type, Filter filter)
         break;
     }
 
-    int32_t width, height, channels;
-    unsigned char *data = stbi_load((Source::root() + Source::texture() + path).c_str(), &width, &height, &channels, 0);
-
     uint32_t channel;
-    switch (channels)
+    switch (image.channels)
     {
         case 1:
             channel = GL_RED;
@@ -573,10 +1244,10 @@ void Texture::load(const std::string &path, Type type, Filter filter)
 
     glGenTextures(1, &texture);
 
-    if (data)
+    if (image.pixels.size())
     {
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, screenChannel, width, height, 0, channel, GL_UNSIGNED_BYTE, data);
+        glstate::bindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, screenChannel, image.width, image.height, 0, channel, GL_UNSIGNED_BYTE, image.pixels.data());
         glGenerateMipmap(GL_TEXTURE_2D);
 
         // set the texture wrapping/filtering options (on the currently bound texture object)
@@ -590,8 +1261,8 @@ void Texture::load(const std::string &path, Type type, Filter filter)
     {
         std::cout << "Failed to load texture: " << path << std::endl;
     }
-    stbi_image_free(data);
-    loadedTextures[path] = Texture(texture, Vector2I(width, height));
+    std::unique_lock<std::shared_mutex> guard(registry);
+    loadedTextures[path] = Texture(texture, Vector2I(image.width, image.height));
 }
 void Texture::load(const std::string &path, const std::vector<std::string> &subPaths, Type type)
 {
@@ -607,7 +1278,7 @@ void Texture::load(const std::string& name, const std::vector<char>& data, float
 
     uint32_t texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glstate::bindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, screenChannel, width, height, 0, imageChannel, GL_UNSIGNED_BYTE, &data[0]);
     glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -618,6 +1289,7 @@ void Texture::load(const std::string& name, const std::vector<char>& data, float
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    std::unique_lock<std::shared_mutex> guard(registry);
     loadedTextures[name] = Texture(texture, Vector2I(width, height));
 }
 void Texture::load(const std::string& name, const std::vector<Color8>& data, float width, float height, Channel channel, Type type, Filter filter)
@@ -638,7 +1310,7 @@ void Texture::load(const std::string& name, const std::vector<Color8>& data, flo
 
     uint32_t texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glstate::bindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, screenChannel, width, height, 0, imageChannel, GL_UNSIGNED_BYTE, &data[0]);
     glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -649,6 +1321,7 @@ void Texture::load(const std::string& name, const std::vector<Color8>& data, flo
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterChannel);
 
+    std::unique_lock<std::shared_mutex> guard(registry);
     loadedTextures[name] = Texture(texture, Vector2I(width, height));
 }
 Texture Texture::loadTo(const std::vector<Color8>& data, float width, float height, Channel channel, Type type, Filter filter)
@@ -669,7 +1342,7 @@ Texture Texture::loadTo(const std::vector<Color8>& data, float width, float heig
 
     uint32_t texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glstate::bindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, screenChannel, width, height, 0, imageChannel, GL_UNSIGNED_BYTE, &data[0]);
     glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -684,6 +1357,7 @@ Texture Texture::loadTo(const std::vector<Color8>& data, float width, float heig
 }
 Texture Texture::get(const std::string &path)
 {
+    std::shared_lock<std::shared_mutex> guard(registry);
     if(!loadedTextures.count(path))
     {
         std::cout << "ERROR :: Texture at \'" << path << "\' could not be found." << std::endl;
@@ -693,6 +1367,7 @@ Texture Texture::get(const std::string &path)
 }
 std::vector<Texture> Texture::get(const std::string &path, const std::vector<std::string> &subPaths, Type type)
 {
+    std::shared_lock<std::shared_mutex> guard(registry);
     std::vector<Texture> textures;
     for (std::string subPath : subPaths)
     {
@@ -702,14 +1377,47 @@ std::vector<Texture> Texture::get(const std::string &path, const std::vector<std
             std::cout << "ERROR :: Texture at \'" << pathName << "\' could not be found." << std::endl;
             return std::vector<Texture>();
         }
-        textures.push_back(loadedTextures[pathName]);
+        textures.push_back(loadedTextures.at(pathName));
     }
     return textures;
 }
 void Texture::clear()
 {
+    std::unique_lock<std::shared_mutex> guard(registry);
     for (auto &pair : loadedTextures)
     {
         glDeleteTextures(1, &pair.second.texture);
     }
+    glstate::invalidate();
+}
+
+uint32_t AnimationClip::create(const AnimationClip& clip)
+{
+    loadedClips.push_back(clip);
+    return loadedClips.size() - 1;
+}
+uint32_t AnimationClip::intern(const AnimationClip& clip)
+{
+    for(uint32_t i = 0; i < loadedClips.size(); i++)
+    {
+        if(loadedClips[i] == clip)
+            return i;
+    }
+    return create(clip);
+}
+const AnimationClip& AnimationClip::get(uint32_t id)
+{
+    if(id >= loadedClips.size())
+    {
+        // an animator with no clip is not an error, only a missing registered clip is
+        static const AnimationClip empty;
+        if(id != ClipAnimator::NONE)
+            std::cout << "ERROR :: AnimationClip " << id << " could not be found." << std::endl;
+        return empty;
+    }
+    return loadedClips[id];
+}
+void AnimationClip::clear()
+{
+    loadedClips.clear();
 }
\ No newline at end of file